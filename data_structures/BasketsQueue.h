@@ -31,10 +31,13 @@
 
 #include "FCBase.h"
 #include "cpp_framework.h"
+#include "EpochReclaimer.h"
+#include "LearnedBackoff.h"
 
 using namespace CCP;
 
-template <class T>
+//with _AUTO_TUNE the fixed countBackOff schedule is replaced by a learned one
+template <class T, bool _AUTO_TUNE = false, bool _AUTO_REWARD = false>
 class BasketsQueue : public FCBase<T> {
 private:
         static final int _MAX_HOPS = 3;
@@ -52,6 +55,8 @@ private:
         AtomicStampedReference<Node>    _head;
         AtomicStampedReference<Node>    _tail;
         int volatile                    _backoff;
+        EpochReclaimer<Node>            _reclaimer;
+        LearnedBackoff<_AUTO_TUNE,_AUTO_REWARD> _learned_backoff;
 
         inline_ static _u32 getTag(AtomicStampedReference<Node>& inRef) {
                 return ((inRef.getStamp() & ~0x8000) & 0xFFFF);
@@ -76,14 +81,14 @@ private:
                 return new_stamp;
         }
 
-        inline_ void free_chain(CasInfo& my_cas_info, AtomicStampedReference<Node> head, AtomicStampedReference<Node> new_head) {
+        inline_ void free_chain(final int iThread, CasInfo& my_cas_info, AtomicStampedReference<Node> head, AtomicStampedReference<Node> new_head) {
                 AtomicStampedReference<Node> next;
 
                 if (_head.compareAndSet( head, new_head.getReference(), head.getStamp(), createStamp(head, 1, false))) {
                         ++(my_cas_info._succ);
                         while (head.getReference() != new_head.getReference() ) {
                                 next = head->_next;
-                                //reclaim_node(head.ptr) 
+                                _reclaimer.retire(iThread, head.getReference());
                                 head = next;
                         }
                 } else {
@@ -95,19 +100,43 @@ private:
                 for (int i = 0; i < n; i++) {;}
         }
 
+        inline_ void backOff(final int iThread, int& backoff) {
+                if ( _AUTO_TUNE ) {
+                        _learned_backoff.backoff(iThread);
+                } else {
+                        countBackOff(backoff * (iThread+1)); backoff*=2;
+                }
+        }
+
 public:
-        BasketsQueue(int backoff_start_value=0) 
-        : _backoff(backoff_start_value)
+        static final int      _NUM_TUNE_KNOBS          = LearnedBackoff<_AUTO_TUNE,_AUTO_REWARD>::_NUM_TUNE_KNOBS;
+        static final boolean  _REWARDS_FROM_ANY_THREAD = true;
+
+        BasketsQueue(int backoff_start_value=0, Monitor* mon = null, LearningEngine* learner = null) 
+        : _backoff(backoff_start_value),
+          _reclaimer(FCBase<T>::_NUM_THREADS),
+          _learned_backoff(FCBase<T>::_NUM_THREADS, mon, learner)
         {
-                Node* sentinel = new Node();
+                Node* sentinel = new (EpochReclaimer<Node>::alloc()) Node();
                 _head.set(sentinel, 0);
                 _tail.set(sentinel, 0);
         }
 
+        ~BasketsQueue() {
+                Node* curr = _head.getReference();
+                while(null != curr) {
+                        Node* final next = curr->_next.getReference();
+                        EpochReclaimer<Node>::destroy(curr);
+                        curr = next;
+                }
+        }
+
         boolean add(final int iThread, PtrNode<T>* final inPtr) {
                 final FCIntPtr inValue = (FCIntPtr) inPtr;
                 CasInfo& my_cas_info = FCBase<T>::_cas_info_ary[iThread];
-                Node* nd = new Node(inValue);
+                typename EpochReclaimer<Node>::Guard guard(_reclaimer, iThread);
+                Node* nd = new (_reclaimer.alloc(iThread)) Node(inValue);
+                _learned_backoff.begin(iThread);
                 int backoff = 1;
                 AtomicStampedReference<Node> tail, next;
 
@@ -126,6 +155,7 @@ public:
                                                         ++(my_cas_info._failed);
 
                                                 ++(my_cas_info._ops);
+                                                _learned_backoff.end(iThread);
                                                 return true;
                                         } else {
                                                 ++(my_cas_info._failed);
@@ -133,12 +163,13 @@ public:
 
                                         next = tail->_next;
                                         while( (getTag(next) == addTag(getTag(tail), 1)) && (!getIsDel(next)) ) {
-                                                countBackOff(backoff * (iThread+1)); backoff*=2;
+                                                backOff(iThread, backoff);
                                                 nd->_next = next;
 
                                                 if (tail->_next.compareAndSet(next.getReference(), nd, next.getStamp(), createStamp(tail, 1, false))) {
                                                         ++(my_cas_info._succ);
                                                         ++(my_cas_info._ops);
+                                                        _learned_backoff.end(iThread);
                                                         return true;
                                                 } else {
                                                         ++(my_cas_info._failed);
@@ -161,6 +192,8 @@ public:
         PtrNode<T>* remove(final int iThread, PtrNode<T>* final inPtr) {
                 final FCIntPtr inValue = (final FCIntPtr) inPtr;
                 CasInfo& my_cas_info = FCBase<T>::_cas_info_ary[iThread];
+                typename EpochReclaimer<Node>::Guard guard(_reclaimer, iThread);
+                _learned_backoff.begin(iThread);
 
                 AtomicStampedReference<Node> head, tail, next, iter;
                 int backoff = 1;
@@ -175,6 +208,7 @@ public:
                                 if (head.getReference() == tail.getReference()) {
                                         if (null == next.getReference()) {
                                                 ++(my_cas_info._ops);
+                                                _learned_backoff.end(iThread);
                                                 return (PtrNode<T>*) FCBase<T>::_NULL_VALUE;
                                         }
                                         while ( (null != next->_next.getReference())  && _tail == tail) {
@@ -198,21 +232,22 @@ public:
                                         if (_head != head) {
                                                 continue;
                                         } else if (iter.getReference() == tail.getReference()) {
-                                                free_chain(my_cas_info, head, iter);
+                                                free_chain(iThread, my_cas_info, head, iter);
                                         } else {
                                                 final FCIntPtr rc_value = next->_value;
                                                 if (iter->_next.compareAndSet(next, next.getReference(), next.getStamp(), createStamp(next, 1, true)) ) {
                                                         ++(my_cas_info._succ);
 
                                                         if (hops >= _MAX_HOPS) {
-                                                                free_chain(my_cas_info, head, next);
+                                                                free_chain(iThread, my_cas_info, head, next);
                                                         }
                                                         ++(my_cas_info._ops);
+                                                        _learned_backoff.end(iThread);
                                                         return (PtrNode<T>*) rc_value;
                                                 } else {
                                                         ++(my_cas_info._failed);
                                                 }
-                                                countBackOff(backoff * (iThread+1)); backoff*=2;
+                                                backOff(iThread, backoff);
                                         }
                                 }
                         }
@@ -230,7 +265,7 @@ public:
         }
 
         const char* name() {
-                return "BasketsQueue";
+                return _AUTO_TUNE ? "SmartBasketsQueue" : "BasketsQueue";
         }
 
 };
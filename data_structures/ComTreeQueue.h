@@ -1,19 +1,30 @@
 #ifndef __COM_TREE_QUEUE__
 #define __COM_TREE_QUEUE__
 
-//FIXME: This seems to have a bug in it
-//I don't understand the placement of threads in the array-based tree
-//Also don't understand if two threads are supposed to share a node or not
-//the LOG in the constructor looks wrong too
-
-
 ////////////////////////////////////////////////////////////////////////////////
 // File    : ComTreeQueue.h
 // Authors : Jonathan Eastep   email: jonathan.eastep@gmail.com
 // Author  : Ms.Moran Tzafrir  email: morantza@gmail.com
-// Written : 16 February 2011, 27 October 2009
+//           agent              email: agent@local
+// Written : 19 October 2026, 16 February 2011, 27 October 2009
+//
+// Combining-tree queue. Threads are grouped into leaves of fan_in threads
+// and leaves into a tree of the same fan-in. A thread publishes its request
+// in its own record; whoever takes a leaf lock claims the pending records of
+// that leaf (by CAS, so a record is never served twice) and climbs. At each
+// inner node the climber publishes its batch in its child slot; the thread
+// that gets the node lock absorbs the batches of its waiting siblings and
+// carries them on. Only the climber that reaches the top takes the root lock
+// and runs the whole batch on a sequential linked-list queue, so the root
+// lock sees at most fan_in contenders instead of one per thread.
+//
+// The fan-in (2..14, and with it the depth) is a discrete knob tuned by the
+// LearningEngine when _AUTO_TUNE is set; the untuned variant is the binary
+// tree. There is one tree per fan-in and they all share the root lock, so a
+// thread may pick a different fan-in than its neighbours at any time.
+// Dequeued list nodes are recycled through a free list owned by the root.
 //
-// Copyright (C) 2011 Jonathan Eastep, 2009 Moran Tzafrir.
+// Copyright (C) 2011 Jonathan Eastep, 2009 Moran Tzafrir, 2026 agent.
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -21,11 +32,11 @@
 // (at your option) any later version.
 //
 // This program is distributed in the hope that it will be useful, but
-// WITHOUT ANY WARRANTY; without even the implied warranty of 
-// MERCHANTABILITY99 or FITNESS FOR A PARTICULAR PURPOSE. See the GNU 
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
 // General Public License for more details.
 //
-// You should have received a copy of the GNU General Public License 
+// You should have received a copy of the GNU General Public License
 // along with this program; if not, write to the Free Software Foundation
 // Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 ////////////////////////////////////////////////////////////////////////////////
@@ -35,456 +46,366 @@
 
 #include "FCBase.h"
 #include "cpp_framework.h"
+#include "LearningEngine.h"
+#include "Monitor.h"
 
 using namespace CCP;
 
-template <class T> class ComTreeQueue : public FCBase<T> {
+template <class T, bool _AUTO_TUNE = false, bool _AUTO_REWARD = false>
+class ComTreeQueue : public FCBase<T> {
 private:
 
-        //-----------------------------------------------------
-        class TTASLock {
-        public:
-                char               _pad1[CACHE_LINE_SIZE];
-                VolatileType<_u32> _lock;
-                char               _pad2[CACHE_LINE_SIZE];
-
-                TTASLock() : _lock(0) {}
-                ~TTASLock() {_lock=0;}
-
-                inline_ void init() {_lock = 0;}
-
-                inline_ void lock(CasInfo& my_cas_info) {
-                        do {
-                                if(0 == _lock && (0 == MUTEX_ENTER(&_lock))) {
-                                        ++(my_cas_info._succ);
-                                        return;
-                                } else {
-                                        ++(my_cas_info._failed);
-                                }
-                        } while(true);
-                }
-
-                inline_ bool tryLock(CasInfo& my_cas_info) {
-                        if ( 0 == MUTEX_ENTER(&_lock) ) {
-                                ++(my_cas_info._succ);
-                                return true;
-                        } else {
-                                ++(my_cas_info._failed);
-                                return false;
-                        }
-                }
-
-                inline_ bool isLocked() {
-                        return 0 != _lock;
-                }
+        //constants -----------------------------------
+        static final int          _MAX_KNOB       = 12;        //disc vals range 0..12
+        static final int          _MIN_FAN_IN     = 2;
+        static final int          _MAX_FAN_IN     = _MIN_FAN_IN + _MAX_KNOB;
+        static final int          _DEFAULT_FAN_IN = 2;
+        static final FCIntPtr     _CLAIMED        = FCBase<T>::_MIN_INT;  //taken by a combiner, not answered yet
 
-                inline_ void unlock() {
-                        MUTEX_EXIT(&_lock);
-                }
-        };
-
-        //inner classes queue ---------------------------------
+        //inner classes -------------------------------
         struct Node {
-                char                 _pad1[CACHE_LINE_SIZE];
-                final FCIntPtr       _value;
-                Node* volatile       _next;
-                int                  d1, d2, d3, d4, d5, d6, d7;
-                int                  d21, d22, d23, d24, d25, d26, d27;
-                char                 _pad2[CACHE_LINE_SIZE];
-
-                Node(final FCIntPtr x) : _value(x) {
-                        _next = null;
-                }
+                FCIntPtr            _value;
+                Node*               _next;
         };
-        //fields queue ----------------------------------------
-        char           _pad1[CACHE_LINE_SIZE];
-        Node* volatile _head;
-        Node* volatile _tail;
-        char           _pad2[CACHE_LINE_SIZE];
-
-        //inner class -----------------------------------------
-        #define REQUEST_NONE  (0)
-        #define REQUEST_LEFT  (4)
-        #define REQUEST_RIGHT (8)
-
-        struct ThreadInfo {
-                char                            _pad1[CACHE_LINE_SIZE];
-                int                             _path_length;
-                int                             _path_ary[128];
-                int                             _add_req_ary[128];
-
-                VolatileType<int>               _num_op;
-                VolatileType<int>               _num_deq;
-                VolatileType<FCIntPtr>          _op_ary[128];
-                VolatileType<ThreadInfo*>       _removers[128];
-                char                            _pad2[CACHE_LINE_SIZE];
-                VolatileType<FCIntPtr>          _rv;
-                char                            _pad3[CACHE_LINE_SIZE];
-
-                ThreadInfo() {
-                        init();
-                }
 
-                void init() {
-                        _path_length    = 0;
-                        _num_op         = 0;
-                        _num_deq        = 0;
-                        _rv             = FCBase<T>::_NULL_VALUE;
-
-                        for (int i=0; i<128; ++i) {
-                                _path_ary[i] = 0;
-                                _add_req_ary[i] = REQUEST_NONE;
-                                _op_ary[i] = 0;
-                                _removers[i] = null;
-                        }
-                }
+        //one per thread, reused for every operation
+        struct Request {
+                FCIntPtr volatile   _req_ans    ATTRIBUTE_CACHE_ALIGNED;
+                char                _pad        ATTRIBUTE_CACHE_ALIGNED;
+        };
 
-                void add_thread_info(ThreadInfo* threadInfo) {
-                        final int copy_op = threadInfo->_num_op;
-                        if((_num_op + copy_op) >= 128) {
-                                System_err_println("*******************************************");
-                        }
-                        for (int i=0; i<copy_op; ++i) {
-                                _op_ary[_num_op+i] = threadInfo->_op_ary[i];
-                        }
-                        _num_op += copy_op; 
+        struct Entry {
+                Request*            _req;
+                FCIntPtr            _op;
+        };
 
-                        final int copy_deq = threadInfo->_num_deq;
-                        if((_num_deq + copy_deq) >= 128) {
-                                System_err_println("*******************************************");
-                        }
-                        for (int i=0; i<copy_deq; ++i) {
-                                _removers[_num_deq+i] = threadInfo->_removers[i];
-                        }
-                        _num_deq += copy_deq; 
-                }
+        //requests a climber carries up the tree
+        struct Batch {
+                Entry*              _entries;
+                int                 _size;
+                int volatile        _absorbed;   //set once another climber has copied it
         };
 
         struct TreeNode {
-                char pad1[CACHE_LINE_SIZE];
-                TTASLock                        _lock;
-                VolatileType<ThreadInfo*>       _left;
-                VolatileType<ThreadInfo*>       _right;
-                char pad2[CACHE_LINE_SIZE];
-
-                TreeNode() : _left(null), _right(null)
-                { }
+                unsigned int volatile   _lock                ATTRIBUTE_CACHE_ALIGNED;
+                Batch* volatile         _slots[_MAX_FAN_IN];   //one per child
+                char                    _pad                 ATTRIBUTE_CACHE_ALIGNED;
         };
 
-        //helper function -------------------------------------
-        inline_ int NearestPowerOfTwo(final int x) {
-                int mask = 1;
-                while(mask < x) {
-                        mask <<= 1;
-                }
-                return mask;
-        }
-        inline_ int left(final int i)                                   { return ((2*i) + 1); } 
-        inline_ int right(final int i)                                  { return ((2*i) + 2); } 
-        inline_ int parent(final int i)                                 { return ((i-1)/2);   } 
-        inline_ int get_thread_indx(final int iThread)  { 
-                return (_NUM_NODES - _MAX_THREADS + (iThread/2)); 
-                //return (_NUM_NODES/2) + iThread;
-        }
-        inline_ bool get_thread_is_left(final int iThread) { return (0 != (iThread%2)); }
-        inline_ bool is_parent_left(final int i) { return (0 != (i%2)); }
-        //inline_ bool is_parent_left(final int i) { return (0 != (parent(i)%2));       }
-
-        //fields ----------------------------------------------
-        char pad3[CACHE_LINE_SIZE];
-        final int               _MAX_THREADS;
-        final int               _LOG_THREADS;
-        final int               _NUM_NODES;
-        TreeNode* final _tree;
-        ThreadInfo*             _thread_info_ary;
-        char pad4[CACHE_LINE_SIZE];
+        //_levels[0] are the leaves, _levels[_depth-1] has a single node
+        struct Tree {
+                int                 _depth;
+                TreeNode**          _levels;
+        };
 
-public:
+        struct ThreadInfo {
+                int                 _ops        ATTRIBUTE_CACHE_ALIGNED;
+                Batch               _batch;
+                char                _pad        ATTRIBUTE_CACHE_ALIGNED;
+        };
 
-        ComTreeQueue() 
-          :     _MAX_THREADS( NearestPowerOfTwo(FCBase<T>::_NUM_THREADS/2) ),
-                //_MAX_THREADS( NearestPowerOfTwo(FCBase<T>::_NUM_THREADS) ),   
-                //_LOG_THREADS( (int) ceil(log((double)FCBase<T>::_NUM_THREADS)) ),
-                _LOG_THREADS( (int) ceil( (double) Integer::log2(FCBase<T>::_NUM_THREADS) ) ),
-                _NUM_NODES( (int) (pow((double)2, (double)(_LOG_THREADS+1))) ),
-                _tree( new TreeNode[_NUM_NODES] )
-        {
-                //cerr << "_NUM_THREADS=" << FCBase<T>::_NUM_THREADS << " _MAX_THREADS=" 
-                //     << _MAX_THREADS << " _LOG_THREADS=" << _LOG_THREADS << " _NUM_NODES=" 
-                //     << _NUM_NODES << endl;
-                //exit(0);
-                //init queue ............................................
-                // Allocate a free node
-                // Make it the only node in the linked list
-                // Both Head and Tail point to it
-                Node* const new_node = new Node(FCBase<T>::_NULL_VALUE);        
-                new_node->_next = null;                                         
-                _head = _tail = new_node;                                       
-
-                //.......................................................
-                _thread_info_ary = new ThreadInfo[FCBase<T>::_NUM_THREADS];
+        //fields --------------------------------------
+        Monitor*                  _mon             ATTRIBUTE_CACHE_ALIGNED;
+        LearningEngine*           _learner;
+        int                       _fan_in_tune_id;
+        Request*                  _req_ary;
+        ThreadInfo*               _thread_info;
+        Tree                      _trees[_MAX_FAN_IN+1];       //indexed by fan-in
+
+        //the sequential queue. only touched under _root_lock
+        volatile unsigned int     _root_lock       ATTRIBUTE_CACHE_ALIGNED;
+        Node*                     _head;
+        Node*                     _tail;
+        Node*                     _free_nodes;
+        char                      _pad             ATTRIBUTE_CACHE_ALIGNED;
+
+        //helper function -----------------------------
+        inline_ static boolean try_lock(volatile unsigned int* lock) {
+                return (0 == *lock) && CAS(lock, 0, 1);
+        }
 
+        inline_ static void unlock(volatile unsigned int* lock) {
+                Memory::read_write_barrier();
+                *lock = 0;
         }
 
-        void execute_requests(ThreadInfo* thread_info, CasInfo& my_cas_info) {
-                // ......................................................
-                int num_added = 0;
-                Memory::read_barrier();
+        inline_ int fan_in(final int iThread) {
+                if ( !_AUTO_TUNE )
+                        return _DEFAULT_FAN_IN;
 
-                int deq_indx = 0;
+                int knob;
+                _learner->tunedvals(iThread, ++_thread_info[iThread]._ops, 1, &_fan_in_tune_id, &knob, _MAX_KNOB);
+                return _MIN_FAN_IN + knob;
+        }
 
-                for (int i=0; i<thread_info->_num_op; ++i) {
-                        final FCIntPtr curr_value = thread_info->_op_ary[i];
+        void build_tree(final int fan_in) {
+                final int num_threads = FCBase<T>::_NUM_THREADS;
+                Tree& tree = _trees[fan_in];
+
+                tree._depth = 1;
+                for (int span=fan_in; span < num_threads; span *= fan_in)
+                        ++(tree._depth);
+
+                tree._levels = new TreeNode*[tree._depth];
+                int span = fan_in;
+                for (int l=0; l<tree._depth; ++l) {
+                        final int width = (num_threads + span - 1) / span;
+                        tree._levels[l] = (TreeNode*) Memory::byte_aligned_malloc(width * sizeof(TreeNode), CACHE_LINE_SIZE);
+                        for (int n=0; n<width; ++n) {
+                                tree._levels[l][n]._lock = 0;
+                                for (int i=0; i<_MAX_FAN_IN; ++i)
+                                        tree._levels[l][n]._slots[i] = null;
+                        }
+                        span *= fan_in;
+                }
+        }
 
-                        //enq
-                        if(curr_value > FCBase<T>::_NULL_VALUE) {                                               
-                                Node* const new_node = new Node(curr_value);    // Allocate a new node from the free list
-                                new_node->_next = null;                         // Set next pointer of node to NULL
-                                _tail->_next = new_node;                        // Link node at the end of the linked list
-                                _tail = new_node;                               // Swing Tail to node
-                                ++(my_cas_info._ops);
-                        } else { //deq
+        inline_ Node* alloc_node(final FCIntPtr x) {
+                Node* new_node = _free_nodes;
+                if(null == new_node)
+                        new_node = new Node();
+                else
+                        _free_nodes = new_node->_next;
+                new_node->_value = x;
+                new_node->_next = null;
+                return new_node;
+        }
 
-                                //if (curr_value != FCBase<T>::_NULL_VALUE) {
-                                if (curr_value != FCBase<T>::_DEQ_VALUE) {
-                                        cerr << "Oops. got weird op= " << curr_value << endl;
-                                        exit(0);
-                                }
+        void execute_batch(final Batch& batch) {
+                for (int i=0; i<batch._size; ++i) {
+                        final Entry& entry = batch._entries[i];
 
-                                if ( deq_indx >= thread_info->_num_deq )
-                                {
-                                        cerr << "Oops. too many deq. deq_indx= " << deq_indx << " num_deq= " << thread_info->_num_deq << endl;
-                                        exit(0);
-                                }
+                        if(entry._op > FCBase<T>::_NULL_VALUE) {
+                                Node* final new_node = alloc_node(entry._op);
+                                _tail->_next = new_node;
+                                _tail = new_node;
+                                entry._req->_req_ans = FCBase<T>::_NULL_VALUE;
+                        } else {
+                                Node* final old_head = _head;
+                                Node* final new_head = old_head->_next;
 
-                                Node* const old_head = _head;                           // Read Head
-                                Node* const new_head = old_head->_next;                 // Read next pointer
-                                if(null != new_head) {                                          // Is queue empty?
-                                        final FCIntPtr curr_value = new_head->_value;      // Queue not empty.  Read value before release
-                                        if ( thread_info->_removers[deq_indx] == null ) {
-                                          cerr << "oops..." << endl;
-                                          exit(0);
-                                        }
-                                        thread_info->_removers[deq_indx++]->_rv = curr_value;
-                                        _head = new_head;                                       // Swing Head to next node
+                                if(null == new_head) {
+                                        entry._req->_req_ans = FCBase<T>::_NULL_VALUE;
                                 } else {
-                                        if ( thread_info->_removers[deq_indx] == null ) {
-                                          cerr << "oops..." << endl;
-                                          exit(0);
-                                        }
-                                        thread_info->_removers[deq_indx++]->_rv = FCBase<T>::_NULL_VALUE;
+                                        final FCIntPtr value = new_head->_value;
+                                        _head = new_head;
+                                        old_head->_next = _free_nodes;
+                                        _free_nodes = old_head;
+                                        entry._req->_req_ans = -(value);
                                 }
-                                ++(my_cas_info._ops);
-                                //}
                         }
                 }
         }
 
-        boolean add(final int iThread, PtrNode<T>* final inPtr) { 
-                final FCIntPtr inValue = (FCIntPtr) inPtr;
-
-                CasInfo&        my_cas_info = FCBase<T>::_cas_info_ary[iThread];
-                ThreadInfo* thread_info = &(_thread_info_ary[iThread]);
-                thread_info->init();
-
-                //Add ENQ request ...........................................
-                ++(thread_info->_num_op);
-                thread_info->_op_ary[0] = inValue;
-                if (inValue == 0 ) {
-                        cerr << "oops. got bad inValue" << endl;
-                        exit(0);
-                }
-
-                int i_node = get_thread_indx(iThread);
-                bool is_left = get_thread_is_left(iThread);
-
-
-                //lock all my path from leaf to root ........................
-                Memory::read_write_barrier();
-                bool is_exec;
-                if (is_left) {
-                        //if ( _tree[i_node]._left != null ) {
-                        //        cerr << "wth? got " << _tree[i_node]._right << " btw, thread_info= " << thread_info << endl;
-                        //      exit(0);
-                        //}
-
-                        _tree[i_node]._left = thread_info;
-                }
-                else {
-                        //if ( _tree[i_node]._right != null ) {
-                        //        cerr << "wth? got " << _tree[i_node]._right << " btw, thread_info= " << thread_info << endl;
-                        //      exit(0);
-                        //}
-
-                        _tree[i_node]._right = thread_info;
+        //called holding the leaf lock of iThread in tree; releases it
+        void combine(final int iThread, final int fan_in, Tree& tree) {
+                Batch& batch = _thread_info[iThread]._batch;
+                batch._size = 0;
+                batch._absorbed = 0;
+
+                //claim the pending requests of our leaf
+                final int first = (iThread / fan_in) * fan_in;
+                final int last = (first + fan_in < FCBase<T>::_NUM_THREADS) ? (first + fan_in) : FCBase<T>::_NUM_THREADS;
+                for (int i=first; i<last; ++i) {
+                        Request& req = _req_ary[i];
+                        final FCIntPtr op = req._req_ans;
+                        if( ((op > FCBase<T>::_NULL_VALUE) || (FCBase<T>::_DEQ_VALUE == op)) && CAS(&(req._req_ans), op, _CLAIMED) ) {
+                                batch._entries[batch._size]._req = &req;
+                                batch._entries[batch._size]._op = op;
+                                ++(batch._size);
+                        }
                 }
 
-                do {
-                        is_exec=true;
-
-                        //climb the tree as much as we can ......................
-                        if (_tree[i_node]._lock.tryLock(my_cas_info)) {
-                                final int i_path = thread_info->_path_length;
-                                ++(thread_info->_path_length);
-                                thread_info->_path_ary[i_path] = i_node;
-
-                                //we have the lock, take the request and climb-up....
-                                if (is_left) {
-                                        if (null != _tree[i_node]._right) {
-                                                thread_info->add_thread_info(_tree[i_node]._right);
-                                                thread_info->_add_req_ary[i_path] = REQUEST_RIGHT;
-                                        }
-                                } else {
-                                        if (null != _tree[i_node]._left) {
-                                                thread_info->add_thread_info(_tree[i_node]._left);
-                                                thread_info->_add_req_ary[i_path] = REQUEST_LEFT;
-                                        }
-                                }
-                                if(0==i_node) //if root
-                                        break;
-                                is_left = is_parent_left(i_node);
-                                i_node = parent(i_node);
-                        } else {
-                                //wait for lock .....................................
+                //climb. levels [0, num_held) are locked by us
+                int num_held = 1;
+                boolean is_absorbed = false;
+                if(0 != batch._size) {
+                        int span = fan_in;
+                        for (int l=1; l<tree._depth; ++l) {
+                                final int i_child = iThread / span;
+                                TreeNode& node = tree._levels[l][i_child / fan_in];
+                                Batch* volatile* final my_slot = &(node._slots[i_child % fan_in]);
+                                span *= fan_in;
+
+                                *my_slot = &batch;
+                                Memory::read_write_barrier();
                                 do {
-                                        //thread_wait(iThread);
-                                } while (_tree[i_node]._lock.isLocked());
-
-                                if (is_left) {
-                                        if(null == _tree[i_node]._left) { //our requests been answered
-                                                is_exec=false;
+                                        if(try_lock(&(node._lock))) {
+                                                if(CAS(my_slot, &batch, (Batch*) null))
+                                                        break;
+                                                //our batch was taken before we got in
+                                                unlock(&(node._lock));
+                                                is_absorbed = true;
                                                 break;
                                         }
-                                } else {
-                                        if(null == _tree[i_node]._right) { //our requests been answered
-                                                is_exec=false;
+                                        if(&batch != *my_slot) {
+                                                is_absorbed = true;
                                                 break;
                                         }
+                                        FCBase<T>::thread_wait(iThread);
+                                } while(true);
+
+                                if(is_absorbed)
+                                        break;
+                                ++num_held;
+
+                                //take over the batches of our waiting siblings
+                                for (int i=0; i<fan_in; ++i) {
+                                        Batch* final other = node._slots[i];
+                                        if((null != other) && CAS(&(node._slots[i]), other, (Batch*) null)) {
+                                                memcpy((void*) &(batch._entries[batch._size]), (void*) other->_entries, other->_size*sizeof(Entry));
+                                                batch._size += other->_size;
+                                                Memory::read_write_barrier();
+                                                other->_absorbed = 1;
+                                        }
                                 }
                         }
-                } while(true);
-
-                //got root execute requests .................................
-                if(is_exec) {
-                        execute_requests(thread_info, my_cas_info);
-                }
 
-                //unlock our path & mark answered requests ..................
-                for (int i=(thread_info->_path_length-1); i>=0; --i) {
-                        final int i_curr_node = thread_info->_path_ary[i];
-                        if (REQUEST_LEFT == thread_info->_add_req_ary[i]) {
-                                _tree[i_curr_node]._left = null;
-                        } else if (REQUEST_RIGHT == thread_info->_add_req_ary[i]) {
-                                _tree[i_curr_node]._right = null;
+                        if(is_absorbed) {
+                                //the absorber copies our entries before it lets us go
+                                while(0 == batch._absorbed)
+                                        FCBase<T>::thread_wait(iThread);
+                        } else {
+                                while(!try_lock(&_root_lock))
+                                        FCBase<T>::thread_wait(iThread);
+                                execute_batch(batch);
+                                //reward under the root lock: one rewarder at a time
+                                if ( _AUTO_REWARD )
+                                        _mon->addreward(iThread, batch._size);
+                                unlock(&_root_lock);
                         }
-                        _tree[i_curr_node]._lock.unlock();
                 }
 
-                //...........................................................
-                return true;
+                //release our path top down
+                int span = 1;
+                for (int l=0; l<num_held; ++l)
+                        span *= fan_in;
+                for (int l=num_held-1; l>=0; --l) {
+                        unlock(&(tree._levels[l][iThread / span]._lock));
+                        span /= fan_in;
+                }
         }
 
-        PtrNode<T>* remove(final int iThread, PtrNode<T>* final inPtr) { 
-                final FCIntPtr inValue = (FCIntPtr) inPtr;
+        FCIntPtr apply(final int iThread, final FCIntPtr op) {
+                CasInfo& my_cas_info = FCBase<T>::_cas_info_ary[iThread];
+                final int my_fan_in = fan_in(iThread);
+                Tree& tree = _trees[my_fan_in];
+                TreeNode& leaf = tree._levels[0][iThread / my_fan_in];
+                Request& my_req = _req_ary[iThread];
 
-                CasInfo&        my_cas_info = FCBase<T>::_cas_info_ary[iThread];
-                ThreadInfo* thread_info = &(_thread_info_ary[iThread]);
-                thread_info->init();
-
-                //Add DEQ request ...........................................
-                int i_node = get_thread_indx(iThread);
-                bool is_left = get_thread_is_left(iThread);
-                ++(thread_info->_num_deq);
-                thread_info->_removers[0] = thread_info;
-                ++(thread_info->_num_op);
-                thread_info->_op_ary[0] = FCBase<T>::_DEQ_VALUE;
-
-                //lock all my path from leaf to root ........................
-                Memory::write_barrier();
-                bool is_exec;
-                if (is_left) 
-                        _tree[i_node]._left = thread_info;
-                else 
-                        _tree[i_node]._right = thread_info;
-                do {
-                        is_exec=true;
-
-                        //climb the tree as much as we can ......................
-                        if (_tree[i_node]._lock.tryLock(my_cas_info)) {
-                                final int i_path = thread_info->_path_length;
-                                ++(thread_info->_path_length);
-                                thread_info->_path_ary[i_path] = i_node;
-
-                                //we have the lock, take the request and climb-up....
-                                if (is_left) {
-                                        if (null != _tree[i_node]._right) {
-                                                thread_info->add_thread_info(_tree[i_node]._right);
-                                                thread_info->_add_req_ary[i_path] = REQUEST_RIGHT;
-                                        }
-                                } else {
-                                        if (null != _tree[i_node]._left) {
-                                                thread_info->add_thread_info(_tree[i_node]._left);
-                                                thread_info->_add_req_ary[i_path] = REQUEST_LEFT;
-                                        }
-                                }
-                                if(0==i_node) //if root
-                                        break;
-                                is_left = is_parent_left(i_node);
-                                i_node = parent(i_node);
-                        } else {
-                                //wait for lock .....................................
-                                do {
-                                        //thread_wait(iThread);
-                                } while (_tree[i_node]._lock.isLocked());
+                Memory::read_write_barrier();
+                my_req._req_ans = op;
+                Memory::read_write_barrier();
 
-                                if (is_left) {
-                                        if(null == _tree[i_node]._left) { //our requests been answered
-                                                is_exec=false;
-                                                break;
-                                        }
-                                } else {
-                                        if(null == _tree[i_node]._right) { //our requests been answered
-                                                is_exec=false;
-                                                break;
-                                        }
-                                }
+                do {
+                        final FCIntPtr ans = my_req._req_ans;
+                        if((op != ans) && (_CLAIMED != ans)) {
+                                ++(my_cas_info._ops);
+                                return ans;
                         }
+                        if((op == ans) && try_lock(&(leaf._lock))) {
+                                ++(my_cas_info._locks);
+                                combine(iThread, my_fan_in, tree);
+                                continue;
+                        }
+                        FCBase<T>::thread_wait(iThread);
                 } while(true);
+        }
 
-                //got root execute requests .................................
-                if(is_exec) {
-                        execute_requests(thread_info, my_cas_info);
+public:
+        //public operations ---------------------------
+        ComTreeQueue(Monitor* mon = null, LearningEngine* learner = null)
+        :       _mon(mon),
+                _learner(learner),
+                _fan_in_tune_id(0),
+                _root_lock(0)
+        {
+                if ( _AUTO_TUNE )
+                        _fan_in_tune_id = _learner->register_sc_tune_id();
+
+                final int num_threads = FCBase<T>::_NUM_THREADS;
+                _req_ary = (Request*) Memory::byte_aligned_malloc(num_threads * sizeof(Request), CACHE_LINE_SIZE);
+                _thread_info = (ThreadInfo*) Memory::byte_aligned_malloc(num_threads * sizeof(ThreadInfo), CACHE_LINE_SIZE);
+                for (int i=0; i<num_threads; ++i) {
+                        _req_ary[i]._req_ans = FCBase<T>::_NULL_VALUE;
+                        _thread_info[i]._ops = 0;
+                        //a batch can end up holding every thread's request
+                        _thread_info[i]._batch._entries = new Entry[num_threads];
+                        _thread_info[i]._batch._size = 0;
+                        _thread_info[i]._batch._absorbed = 0;
                 }
 
-                //unlock our path & mark answered requests ..................
-                for (int i=(thread_info->_path_length-1); i>=0; --i) {
-                        final int i_curr_node = thread_info->_path_ary[i];
-                        if (REQUEST_LEFT == thread_info->_add_req_ary[i]) {
-                                _tree[i_curr_node]._left = null;
-                        } else if (REQUEST_RIGHT == thread_info->_add_req_ary[i]) {
-                                _tree[i_curr_node]._right = null;
-                        }
-                        _tree[i_curr_node]._lock.unlock();
+                for (int f=0; f<=_MAX_FAN_IN; ++f) {
+                        _trees[f]._depth = 0;
+                        _trees[f]._levels = null;
+                }
+                if ( _AUTO_TUNE ) {
+                        for (int f=_MIN_FAN_IN; f<=_MAX_FAN_IN; ++f)
+                                build_tree(f);
+                } else {
+                        build_tree(_DEFAULT_FAN_IN);
                 }
 
-                //...........................................................
-                return (PtrNode<T>*) thread_info->_rv.get();
+                _head = _tail = new Node();
+                _head->_value = FCBase<T>::_NULL_VALUE;
+                _head->_next = null;
+                _free_nodes = null;
+
+                Memory::read_write_barrier();
         }
 
-        PtrNode<T>* contain(final int iThread, PtrNode<T>* final inPtr) { 
+        ~ComTreeQueue() {
+                Node* curr = _head;
+                while(null != curr) {
+                        Node* final next = curr->_next;
+                        delete curr;
+                        curr = next;
+                }
+                curr = _free_nodes;
+                while(null != curr) {
+                        Node* final next = curr->_next;
+                        delete curr;
+                        curr = next;
+                }
+
+                for (int f=0; f<=_MAX_FAN_IN; ++f) {
+                        for (int l=0; l<_trees[f]._depth; ++l)
+                                Memory::byte_aligned_free(_trees[f]._levels[l]);
+                        delete[] _trees[f]._levels;
+                }
+
+                for (int i=0; i<FCBase<T>::_NUM_THREADS; ++i)
+                        delete[] _thread_info[i]._batch._entries;
+                Memory::byte_aligned_free(_thread_info);
+                Memory::byte_aligned_free(_req_ary);
+        }
+
+        //enq ......................................................
+        boolean add(final int iThread, PtrNode<T>* final inPtr) {
+                apply(iThread, (FCIntPtr) inPtr);
+                return true;
+        }
+
+        //deq ......................................................
+        PtrNode<T>* remove(final int iThread, PtrNode<T>* final inPtr) {
+                return (PtrNode<T>*) -(apply(iThread, FCBase<T>::_DEQ_VALUE));
+        }
+
+        //peek .....................................................
+        PtrNode<T>* contain(final int iThread, PtrNode<T>* final inPtr) {
                 final FCIntPtr inValue = (FCIntPtr) inPtr;
-                return FCBase<T>::_NULL_VALUE;
+                return (PtrNode<T>*) FCBase<T>::_NULL_VALUE;
         }
 
+        //general .....................................................
         int size() {
                 return 0;
         }
 
         const char* name() {
-                return "ComTreeQueue";
+                return _AUTO_TUNE ? "SmartComTreeQueue" : "ComTreeQueue";
         }
 
 };
 
-
 #endif
@@ -0,0 +1,168 @@
+#ifndef __DARY_HEAP__
+#define __DARY_HEAP__
+
+////////////////////////////////////////////////////////////////////////////////
+// File    : DaryHeap.h
+// Author  : agent   email: agent@local
+// Written : 19 October 2026
+//
+// Implicit d-ary min-heap over an array of (key, element) entries. Drop-in
+// alternative to PairHeap as the sequential heap behind SmartPairHeap: no
+// per-element allocation and the keys compared while sifting sit inline.
+// The array is offset by _D-1 entries so that each group of siblings starts
+// on a cache line boundary (exactly one line for _D=4 on 64-bit).
+//
+// Copyright (C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+////////////////////////////////////////////////////////////////////////////////
+// TODO:
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include "cpp_framework.h"
+#include "Node.h"
+
+using namespace CCP;
+
+template <class T, int _D = 4>
+class DaryHeap {
+private:
+        struct Entry {
+                FCIntPtr      _key;
+                PtrNode<T>*   _element;
+        };
+
+        static final int  _OFFSET       = _D - 1;
+        static final int  _INITIAL_SIZE = 1024;
+
+        Entry*          _buff;
+        Entry*          _ary;
+        int             _size;
+        int             _ary_size;
+
+        void allocate( int ary_size ) {
+                _ary_size = ary_size;
+                _buff = (Entry*) Memory::byte_aligned_malloc( (_ary_size + _OFFSET) * sizeof(Entry), CACHE_LINE_SIZE );
+                _ary = _buff + _OFFSET;
+        }
+
+        //only happens when the heap outgrows every previous size; amortized away
+        void doubleIfFull() {
+                if ( _size == _ary_size ) {
+                        Entry* oldBuff = _buff;
+                        Entry* oldArray = _ary;
+
+                        allocate( 2 * _ary_size );
+                        memcpy( _ary, oldArray, _size * sizeof(Entry) );
+                        Memory::byte_aligned_free( oldBuff );
+                }
+        }
+
+public:
+
+        DaryHeap() {
+                _size = 0;
+                allocate( _INITIAL_SIZE );
+        }
+
+        ~DaryHeap() {
+                Memory::byte_aligned_free( _buff );
+        }
+
+        void insert( PtrNode<T>* final x ) {
+                doubleIfFull();
+
+                final FCIntPtr key = x->getkey();
+                int i = _size++;
+                while ( i > 0 ) {
+                        final int parent = (i - 1) / _D;
+                        if ( !(key < _ary[parent]._key) )
+                                break;
+                        _ary[i] = _ary[parent];
+                        i = parent;
+                }
+                _ary[i]._key = key;
+                _ary[i]._element = x;
+        }
+
+        PtrNode<T>* deleteMin() {
+                if( isEmpty() )
+                        return null;
+
+                PtrNode<T>* final x = _ary[0]._element;
+                if ( 0 == --_size )
+                        return x;
+
+                final Entry last = _ary[_size];
+                int i = 0;
+                do {
+                        final int first = _D * i + 1;
+                        if ( first >= _size )
+                                break;
+
+                        final int end = (first + _D < _size) ? (first + _D) : _size;
+                        int best = first;
+                        for ( int c = first + 1; c < end; ++c ) {
+                                if ( _ary[c]._key < _ary[best]._key )
+                                        best = c;
+                        }
+
+                        if ( !(_ary[best]._key < last._key) )
+                                break;
+                        _ary[i] = _ary[best];
+                        i = best;
+                } while ( true );
+                _ary[i] = last;
+
+                return x;
+        }
+
+        boolean isEmpty() {
+                return (0 == _size);
+        }
+
+        //only valid when the heap is not empty
+        FCIntPtr minKey() {
+                return _ary[0]._key;
+        }
+
+        void makeEmpty() {
+                _size = 0;
+        }
+
+        //"<prefix>Dary<_D>Heap", so the arities can be told apart
+        static final char* name(final char* prefix, char* buf, int len) {
+                snprintf(buf, len, "%sDary%dHeap", prefix, _D);
+                return buf;
+        }
+
+        static final char* name_fc() {
+                static char buf[32];
+                static final char* const n = name("FC", buf, sizeof(buf));
+                return n;
+        }
+
+        static final char* name_smart() {
+                static char buf[32];
+                static final char* const n = name("Smart", buf, sizeof(buf));
+                return n;
+        }
+
+};
+
+#endif
@@ -10,6 +10,11 @@
 // 
 // Elimination Stack
 //
+// With _AUTO_TUNE the width of the elimination array in use and the time a
+// pusher waits in it for a partner are discrete knobs tuned online by the
+// LearningEngine from the Monitor reward, the same way SmartQueue tunes its
+// scancount. Without it the stack behaves as before (fixed width, yield).
+//
 // Copyright (C) 2011 Jonathan Eastep, 2009 Moran Tzafrir.
 // You can use this file only by explicit written approval from Jonathan Eastep
 // per Moran's original license.
@@ -20,13 +25,20 @@
 
 #include "FCBase.h"
 #include "cpp_framework.h"
+#include "LearningEngine.h"
+#include "Monitor.h"
 
 using namespace CCP;
 
-template <class T>
+template <class T, bool _AUTO_TUNE = false, bool _AUTO_REWARD = false>
 class EliminationStack : public FCBase<T> {
 private:
 
+        //constants -----------------------------------
+        static final int        _MAX_KNOB     = 12;   //disc vals range 0..12
+        static final int        _WAIT_UNIT    = 16;   //spins per squared wait step
+        static final int        _REWARD_BATCH = 64;
+
         struct Node {
                 FCIntPtr volatile      _value;
                 int                     d1, d2, d3, d4, d5, d6, d7;
@@ -36,21 +48,62 @@ private:
                 Node(final FCIntPtr inValue) : _value(inValue), _next(null) {}
         };
 
+        struct ThreadInfo {
+                int                     _ops       ATTRIBUTE_CACHE_ALIGNED;
+                int                     _width;
+                int                     _wait;
+                char                    _pad       ATTRIBUTE_CACHE_ALIGNED;
+        };
+
         final int               _ELIMINATION_SIZE;
         AtomicReference<Node>   _top;
         AtomicReference<Node>*  _elimination_ary;
         VolatileType<int>       _hint_last_waiter_index;
 
-public:
-        EliminationStack() 
-        : _top(null), _ELIMINATION_SIZE(FCBase<T>::_NUM_THREADS/2) 
-        { 
-                if(_ELIMINATION_SIZE > 0)
-                        _elimination_ary = new AtomicReference<Node>[_ELIMINATION_SIZE];
-                _hint_last_waiter_index = 0;
+        //tuning
+        Monitor*                _mon               ATTRIBUTE_CACHE_ALIGNED;
+        LearningEngine*         _learner;
+        int                     _tune_ids[2];      //width, wait
+        ThreadInfo*             _thread_info;
+        char                    _pad               ATTRIBUTE_CACHE_ALIGNED;
+
+        //helper function -----------------------------
+
+        //refresh this thread's width and wait from the learner
+        inline_ void tune(final int iThread) {
+                ThreadInfo& info = _thread_info[iThread];
+                int knob[2];
+                _learner->tunedvals(iThread, ++info._ops, 2, _tune_ids, knob, _MAX_KNOB);
+                final int width = knob[0];
+                final int wait = knob[1];
+                info._width = 1 + (width * (_ELIMINATION_SIZE-1) + _MAX_KNOB/2) / _MAX_KNOB;
+                info._wait = _WAIT_UNIT * wait * wait;
         }
 
-        boolean add(final int iThread, PtrNode<T>* final inPtr) {
+        //credit the operation tune() counted, once it is done
+        inline_ void reward(final int iThread) {
+                if ( _AUTO_REWARD )
+                        _mon->addbatchedreward(iThread, _thread_info[iThread]._ops, _REWARD_BATCH);
+        }
+
+        //give a partner time to take nd out of the slot
+        inline_ void wait_in_slot(final int iThread, AtomicReference<Node>& slot, Node* final nd) {
+                if ( !_AUTO_TUNE ) {
+                        Thread::yield();
+                        return;
+                }
+
+                final int wait = _thread_info[iThread]._wait;
+                if ( 0 == wait ) {
+                        Thread::yield();
+                        return;
+                }
+                for (int i=0; (i<wait) && (nd == slot.getRefNotSafe()); ++i)
+                        Memory::read_barrier();
+        }
+
+        //use the first width slots of the elimination array
+        boolean push(final int iThread, PtrNode<T>* final inPtr, final int width) {
                 final FCIntPtr inValue = (FCIntPtr) inPtr;
 
                 Node* nd = new Node(inValue);
@@ -63,25 +116,27 @@ public:
                                 return true;
                         else {
                                 int iCheck = _hint_last_waiter_index;
-                                for (int i=0; i<_ELIMINATION_SIZE; ++i) {
+                                if(iCheck >= width)
+                                        iCheck = 0;
+                                for (int i=0; i<width; ++i) {
                                         final Node* elimination_node = _elimination_ary[iCheck].get();
                                         if(null == elimination_node && _elimination_ary[iCheck].compareAndSet(null, nd)) {
                                                 _hint_last_waiter_index = iCheck; 
-                                                Thread::yield();
+                                                wait_in_slot(iThread, _elimination_ary[iCheck], nd);
                                                 if(_elimination_ary[iCheck].compareAndSet(nd, null))
                                                         break;
                                                 else 
                                                         return true;
                                         }
                                         ++iCheck;
-                                        if(iCheck >= _ELIMINATION_SIZE)
+                                        if(iCheck >= width)
                                                 iCheck = 0;
                                 }
                         }
                 } while(true);
         }
 
-        PtrNode<T>* remove(final int iThread, PtrNode<T>* final inPtr) {
+        PtrNode<T>* pop(final int iThread, PtrNode<T>* final inPtr, final int width) {
                 final FCIntPtr inValue = (FCIntPtr) inPtr;
 
                 do {
@@ -95,27 +150,89 @@ public:
                                 return (PtrNode<T>*) curr_top->_value;
                         } else {
                                 int iCheck = _hint_last_waiter_index;
-                                for (int i=0; i<_ELIMINATION_SIZE; ++i) {
+                                if(iCheck >= width)
+                                        iCheck = 0;
+                                for (int i=0; i<width; ++i) {
                                         final Node* elimination_node = _elimination_ary[iCheck].getRefNotSafe();
                                         if(null != elimination_node && _elimination_ary[iCheck].compareAndSet(elimination_node, null)) {
                                                 Memory::read_barrier();
                                                 return (PtrNode<T>*) elimination_node->_value;
                                         }
                                         ++iCheck;
-                                        if(iCheck >= _ELIMINATION_SIZE)
+                                        if(iCheck >= width)
                                                 iCheck = 0;
                                 }
                         }
                 } while(true);
         }
 
+public:
+        static final int      _NUM_TUNE_KNOBS          = 2;    //width, wait
+        static final boolean  _REWARDS_FROM_ANY_THREAD = true;
+
+        EliminationStack(Monitor* mon = null, LearningEngine* learner = null) 
+        : _top(null), 
+          _ELIMINATION_SIZE( _AUTO_TUNE ? ((FCBase<T>::_NUM_THREADS > 1) ? FCBase<T>::_NUM_THREADS : 1) : FCBase<T>::_NUM_THREADS/2 ),
+          _elimination_ary(null),
+          _mon(mon),
+          _learner(learner),
+          _thread_info(null)
+        { 
+                if(_ELIMINATION_SIZE > 0)
+                        _elimination_ary = new AtomicReference<Node>[_ELIMINATION_SIZE];
+                _hint_last_waiter_index = 0;
+
+                _tune_ids[0] = _tune_ids[1] = 0;
+                if ( _AUTO_TUNE ) {
+                        _tune_ids[0] = _learner->register_sc_tune_id();
+                        _tune_ids[1] = _learner->register_sc_tune_id();
+
+                        _thread_info = (ThreadInfo*) Memory::byte_aligned_malloc(FCBase<T>::_NUM_THREADS*sizeof(ThreadInfo), CACHE_LINE_SIZE);
+                        for (int i=0; i<FCBase<T>::_NUM_THREADS; ++i) {
+                                _thread_info[i]._ops = 0;
+                                _thread_info[i]._width = _ELIMINATION_SIZE;
+                                _thread_info[i]._wait = 0;
+                        }
+                }
+
+                Memory::read_write_barrier();
+        }
+
+        virtual ~EliminationStack()
+        {
+                if ( _ELIMINATION_SIZE > 0 )
+                        delete[] _elimination_ary;
+                if ( null != _thread_info )
+                        Memory::byte_aligned_free(_thread_info);
+        }
+
+        boolean add(final int iThread, PtrNode<T>* final inPtr) {
+                if ( !_AUTO_TUNE )
+                        return push(iThread, inPtr, _ELIMINATION_SIZE);
+
+                tune(iThread);
+                final boolean rv = push(iThread, inPtr, _thread_info[iThread]._width);
+                reward(iThread);
+                return rv;
+        }
+
+        PtrNode<T>* remove(final int iThread, PtrNode<T>* final inPtr) {
+                if ( !_AUTO_TUNE )
+                        return pop(iThread, inPtr, _ELIMINATION_SIZE);
+
+                tune(iThread);
+                PtrNode<T>* final rv = pop(iThread, inPtr, _thread_info[iThread]._width);
+                reward(iThread);
+                return rv;
+        }
+
         PtrNode<T>* contain(final int iThread, PtrNode<T>* final inPtr) {
                 final FCIntPtr inValue = (FCIntPtr) inPtr;
                 return FCBase<T>::_NULL_VALUE;
         }
 
         const char* name() {
-                return "EliminationStack";
+                return _AUTO_TUNE ? "SmartElimStack" : "EliminationStack";
         }
 
         int size() {
@@ -0,0 +1,204 @@
+#ifndef __FAA_QUEUE__
+#define __FAA_QUEUE__
+
+////////////////////////////////////////////////////////////////////////////////
+// File    : FAAQueue.h
+// Author  : agent   email: agent@local
+// Written : 19 October 2026
+//
+// Fetch-and-add queue over a linked list of array segments, in the spirit
+// of LCRQ. Enqueuers and dequeuers claim cells with a FAA on the segment's
+// tail/head index instead of retrying CAS on a shared pointer, so under
+// contention each operation costs one FAA plus one uncontended CAS/SWAP on
+// its own cell. A dequeuer that overtakes an enqueuer poisons the cell and
+// the enqueuer simply claims another. When a segment fills up a new one is
+// linked after it, MSQueue style; drained segments are retired through the
+// EpochReclaimer and reused.
+//
+// LCRQ proper needs a double-width CAS on (index, value) cells to recycle a
+// ring in place; this uses single-word CAS/SWAP only, which the framework
+// provides on every supported platform.
+//
+// Copyright (C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+////////////////////////////////////////////////////////////////////////////////
+// TODO:
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "FCBase.h"
+#include "cpp_framework.h"
+#include "EpochReclaimer.h"
+
+using namespace CCP;
+
+template <class T>
+class FAAQueue : public FCBase<T> {
+private:
+
+        //constants -----------------------------------
+        static final int        _SEGMENT_SIZE = 1024;
+        static final FCIntPtr   _TAKEN        = FCBase<T>::_MIN_INT;  //poisoned by a dequeuer
+        static final int        _MAX_FREE_SEGMENTS = 8;               //per thread; a segment is ~8KB
+
+        struct Segment {
+                int volatile            _deq_indx     ATTRIBUTE_CACHE_ALIGNED;
+                int volatile            _enq_indx     ATTRIBUTE_CACHE_ALIGNED;
+                Segment* volatile       _next         ATTRIBUTE_CACHE_ALIGNED;
+                FCIntPtr volatile       _cells[_SEGMENT_SIZE];
+
+                Segment() : _deq_indx(0), _enq_indx(0), _next(null) {
+                        for (int i=0; i<_SEGMENT_SIZE; ++i)
+                                _cells[i] = FCBase<T>::_NULL_VALUE;
+                }
+
+                //first segment of a new tail, already holding value
+                Segment(final FCIntPtr value) : _deq_indx(0), _enq_indx(1), _next(null) {
+                        _cells[0] = value;
+                        for (int i=1; i<_SEGMENT_SIZE; ++i)
+                                _cells[i] = FCBase<T>::_NULL_VALUE;
+                }
+        };
+
+        typedef EpochReclaimer<Segment, _MAX_FREE_SEGMENTS> Reclaimer;
+
+        //fields --------------------------------------
+        AtomicReference<Segment>        _head       ATTRIBUTE_CACHE_ALIGNED;
+        AtomicReference<Segment>        _tail       ATTRIBUTE_CACHE_ALIGNED;
+        Reclaimer                       _reclaimer;
+        char                            _pad        ATTRIBUTE_CACHE_ALIGNED;
+
+public:
+        //public operations ---------------------------
+        FAAQueue()
+        : _reclaimer(FCBase<T>::_NUM_THREADS)
+        {
+                Segment* final sentinel = new (Reclaimer::alloc()) Segment();
+                _head.set(sentinel);
+                _tail.set(sentinel);
+        }
+
+        ~FAAQueue() {
+                Segment* curr = _head.get();
+                while(null != curr) {
+                        Segment* final next = curr->_next;
+                        Reclaimer::destroy(curr);
+                        curr = next;
+                }
+        }
+
+        //enq ......................................................
+        boolean add(final int iThread, PtrNode<T>* final inPtr) {
+                final FCIntPtr inValue = (FCIntPtr) inPtr;
+                CasInfo& my_cas_info = FCBase<T>::_cas_info_ary[iThread];
+                typename Reclaimer::Guard guard(_reclaimer, iThread);
+
+                do {
+                        Segment* final tail = _tail.get();
+                        final int idx = FAADD(&(tail->_enq_indx), 1);
+
+                        if(idx < _SEGMENT_SIZE) {
+                                //a dequeuer may have poisoned the cell first; then claim another
+                                if(CAS(&(tail->_cells[idx]), FCBase<T>::_NULL_VALUE, inValue)) {
+                                        ++(my_cas_info._succ);
+                                        ++(my_cas_info._ops);
+                                        return true;
+                                }
+                                ++(my_cas_info._failed);
+                                continue;
+                        }
+
+                        //segment is full. link a new one or help swing the tail
+                        if(tail != _tail.get())
+                                continue;
+
+                        Segment* final next = tail->_next;
+                        if(null == next) {
+                                Segment* final new_seg = new (_reclaimer.alloc(iThread)) Segment(inValue);
+                                if(CAS(&(tail->_next), (Segment*) null, new_seg)) {
+                                        ++(my_cas_info._succ);
+                                        _tail.compareAndSet(tail, new_seg);
+                                        ++(my_cas_info._ops);
+                                        return true;
+                                }
+                                ++(my_cas_info._failed);
+                                //never published; hand the memory straight back
+                                _reclaimer.release(iThread, new_seg);
+                        } else {
+                                _tail.compareAndSet(tail, next);
+                        }
+                } while(true);
+        }
+
+        //deq ......................................................
+        PtrNode<T>* remove(final int iThread, PtrNode<T>* final inPtr) {
+                CasInfo& my_cas_info = FCBase<T>::_cas_info_ary[iThread];
+                typename Reclaimer::Guard guard(_reclaimer, iThread);
+
+                do {
+                        Segment* final head = _head.get();
+
+                        //don't burn indices (and poison cells) when plainly empty
+                        if((head->_deq_indx >= head->_enq_indx) && (null == head->_next)) {
+                                ++(my_cas_info._ops);
+                                return (PtrNode<T>*) FCBase<T>::_NULL_VALUE;
+                        }
+
+                        final int idx = FAADD(&(head->_deq_indx), 1);
+
+                        if(idx < _SEGMENT_SIZE) {
+                                final FCIntPtr value = FASTORE(&(head->_cells[idx]), _TAKEN);
+                                if(FCBase<T>::_NULL_VALUE != value) {
+                                        ++(my_cas_info._ops);
+                                        return (PtrNode<T>*) value;
+                                }
+                                //overtook the enqueuer that owns this cell
+                                continue;
+                        }
+
+                        //segment is drained. move on to the next one
+                        Segment* final next = head->_next;
+                        if(null == next) {
+                                ++(my_cas_info._ops);
+                                return (PtrNode<T>*) FCBase<T>::_NULL_VALUE;
+                        }
+                        if(_head.compareAndSet(head, next)) {
+                                ++(my_cas_info._succ);
+                                _reclaimer.retire(iThread, head);
+                        } else {
+                                ++(my_cas_info._failed);
+                        }
+                } while(true);
+        }
+
+        //peek .....................................................
+        PtrNode<T>* contain(final int iThread, PtrNode<T>* final inPtr) {
+                final FCIntPtr inValue = (FCIntPtr) inPtr;
+                return (PtrNode<T>*) FCBase<T>::_NULL_VALUE;
+        }
+
+        //general .....................................................
+        int size() {
+                return 0;
+        }
+
+        const char* name() {
+                return "FAAQueue";
+        }
+
+};
+
+#endif
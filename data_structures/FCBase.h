@@ -107,6 +107,13 @@ public:
         static final FCIntPtr _MIN_INT    = _FC_MIN_INT;
         static final FCIntPtr _MAX_INT    = _FC_MAX_INT;
 
+        //what the benchmark needs before building a structure: the knobs each
+        //instance registers with its learner (not counting a learned
+        //SmartLockLite algorithm), and whether every thread using it adds
+        //its own reward rather than one at a time (combiner, root lock holder)
+        static final int      _NUM_TUNE_KNOBS          = 1;
+        static final boolean  _REWARDS_FROM_ANY_THREAD = false;
+
         CCP::AtomicInteger  _barr  ATTRIBUTE_CACHE_ALIGNED;
 
 protected:
@@ -17,6 +17,7 @@
 //------------------------------------------------------------------------------
 
 #include "FCBase.h"
+#include "EpochReclaimer.h"
 #include "cpp_framework.h"
 
 using namespace CCP;
@@ -33,20 +34,22 @@ protected://types
                 final FCIntPtr                          _key;
                 PtrNode<T>* final                       _element;
                 final int                               _topLevel;
-                AtomicMarkableReference<Node>* final    _next;
+                int volatile                            _level_removed;
+                //inline, so a node the reclaimer recycles needs no allocation
+                AtomicMarkableReference<Node>           _next[_MAX_LEVEL + 1];
 
                 Node(PtrNode<T>* final theElement) 
                   :     _key(theElement->getkey()), 
                         _element(theElement),
                         _topLevel(_MAX_LEVEL), 
-                        _next(new AtomicMarkableReference<Node>[_MAX_LEVEL + 1])
+                        _level_removed(0)
                 {}// constructor for sentinel nodes
 
                 Node(PtrNode<T>* final theElement, final int height) 
                   :     _key(theElement->getkey()),
                         _element(theElement),
                         _topLevel(height), 
-                        _next(new AtomicMarkableReference<Node>[height + 1])
+                        _level_removed(0)
                 {}// constructor for regular nodes
         };
 
@@ -55,6 +58,7 @@ protected://fields
         VolatileType<Node*>     _head;
         VolatileType<Node*>     _tail;
         TTASLock                _lock_removemin;
+        EpochReclaimer<Node>    _reclaimer;
 
 protected://methods
         int randomLevel() {
@@ -76,7 +80,7 @@ protected://methods
                         return level;
         }
 
-        Node* find(final FCIntPtr key, Node** preds, Node** succs) {
+        Node* find(final int iThread, final FCIntPtr key, Node** preds, Node** succs) {
                 boolean marked = false;
                 boolean snip;
                 Node* pPred;
@@ -96,8 +100,10 @@ protected://methods
                                                 if (!snip) 
                                                         goto find_retry;
 
-                                                //if(++(pCurr->_level_removed) == pCurr->_topLevel)
-                                                //      pCurr.retire();
+                                                //each level is linked and snipped exactly once, so
+                                                //the last snip makes the node unreachable
+                                                if((FAADD(&(pCurr->_level_removed), 1) + 1) == pCurr->_topLevel)
+                                                        _reclaimer.retire(iThread, pCurr);
 
                                                 pCurr = pPred->_next[iLevel].getReference();
                                                 pSucc = pCurr->_next[iLevel].get(&marked);
@@ -126,8 +132,9 @@ public://methods
 
         LFSkipList() 
         :       _random_seed( Random::getSeed() ),
-                _head( new Node( new PtrNode<T>(FCBase<T>::_MIN_INT, null) ) ),
-                _tail( new Node( new PtrNode<T>(FCBase<T>::_MAX_INT, null) ) )
+                _head( new (EpochReclaimer<Node>::alloc()) Node( new PtrNode<T>(FCBase<T>::_MIN_INT, null) ) ),
+                _tail( new (EpochReclaimer<Node>::alloc()) Node( new PtrNode<T>(FCBase<T>::_MAX_INT, null) ) ),
+                _reclaimer(FCBase<T>::_NUM_THREADS)
         {
                 for (int iLevel = 0; iLevel < _head->_topLevel; ++iLevel) {
                         _head->_next[iLevel].set(_tail, false);
@@ -135,9 +142,15 @@ public://methods
         }
 
         ~LFSkipList() {
-                delete _head;
-                delete _tail;
-                //need to delete the rest
+                //nodes still linked at level 0 can't have been retired yet
+                Node* curr = _head->_next[0].getReference();
+                while(_tail != curr) {
+                        Node* final next = curr->_next[0].getReference();
+                        EpochReclaimer<Node>::destroy(curr);
+                        curr = next;
+                }
+                EpochReclaimer<Node>::destroy(_head);
+                EpochReclaimer<Node>::destroy(_tail);
         }
 
         //enq ......................................................
@@ -149,9 +162,10 @@ public://methods
                 Node* pSucc;
                 Node* new_node = null;
                 int topLevel = 0;
+                typename EpochReclaimer<Node>::Guard guard(_reclaimer, iThread);
 
                 while (true) {
-                        Node* final found_node = find(inKey, preds, succs);
+                        Node* final found_node = find(iThread, inKey, preds, succs);
                         //if(null != found_node) {
                         //      return true;
                         //}
@@ -162,7 +176,7 @@ public://methods
 
                         if (null == new_node) {
                                 topLevel = randomLevel();
-                                new_node = new Node(inPtr, topLevel);
+                                new_node = new (_reclaimer.alloc(iThread)) Node(inPtr, topLevel);
                         }
 
                         // prepare new node
@@ -183,7 +197,21 @@ public://methods
                                         if (pPred->_next[iLevel].compareAndSet(pSucc, new_node, false, false)) {
                                                 break;
                                         }
-                                        find(inKey, preds, succs); // find new preds and succs
+                                        find(iThread, inKey, preds, succs); // find new preds and succs
+
+                                        //point at the new successor before retrying; the old one
+                                        //may have been unlinked and retired meanwhile. a marked
+                                        //level means new_node is being removed: stop going up
+                                        boolean marked = false;
+                                        Node* final pOld = new_node->_next[iLevel].get(&marked);
+                                        if (marked || ((pOld != succs[iLevel]) &&
+                                            !new_node->_next[iLevel].compareAndSet(pOld, succs[iLevel], false, false))) {
+                                                //levels never linked are never snipped; count them here
+                                                //so the last snip (or this) retires the node
+                                                if((FAADD(&(new_node->_level_removed), topLevel - iLevel) + topLevel - iLevel) == new_node->_topLevel)
+                                                        _reclaimer.retire(iThread, new_node);
+                                                return true;
+                                        }
                                 }
                         }
 
@@ -196,6 +224,7 @@ public://methods
 
                 Node* succs[_MAX_LEVEL + 1];
                 Node* pSucc;
+                typename EpochReclaimer<Node>::Guard guard(_reclaimer, iThread);
                 _lock_removemin.lock();
                 while (true) {
 
@@ -206,7 +235,7 @@ public://methods
                                 return FCBase<T>::_NULL_VALUE;
                         }
                         final FCIntPtr key = pNodeToRemove->_key;
-                        find(key, null, succs);
+                        find(iThread, key, null, succs);
                         pNodeToRemove = succs[0];
 
                         //logically remove node
@@ -227,7 +256,7 @@ public://methods
                                 pSucc = succs[0]->_next[0].get(&marked);
                                 if (iMarkedIt) {
                                         // run find to remove links of the logically removed node
-                                        find(key, null, succs);
+                                        find(iThread, key, null, succs);
                                         _lock_removemin.unlock();
 					PtrNode<T>* rv = pNodeToRemove->_element;
 					//delete pNodeToRemove;
@@ -253,6 +282,7 @@ public://methods
                 Node* pPred;
                 Node* pCurr;
                 Node* pSucc;
+                typename EpochReclaimer<Node>::Guard guard(_reclaimer, iThread);
 
                 pPred = _head;
                 boolean marked = false;
@@ -26,6 +26,7 @@
 
 #include "FCBase.h"
 #include "cpp_framework.h"
+#include "EpochReclaimer.h"
 
 using namespace CCP;
 
@@ -43,16 +44,28 @@ private:
         };
 
         AtomicReference<Node>   _top;
+        EpochReclaimer<Node>    _reclaimer;
 
 public:
         LFStack() 
-        : _top(null) 
+        : _top(null),
+          _reclaimer(FCBase<T>::_NUM_THREADS)
         { }
 
+        ~LFStack() {
+                Node* curr = _top.get();
+                while(null != curr) {
+                        Node* final next = curr->_next;
+                        EpochReclaimer<Node>::destroy(curr);
+                        curr = next;
+                }
+        }
+
         boolean add(final int iThread, PtrNode<T>* final inPtr) {
                 final FCIntPtr inValue = (FCIntPtr) inPtr;
 
-                Node* final nd = new Node(inValue);
+                typename EpochReclaimer<Node>::Guard guard(_reclaimer, iThread);
+                Node* final nd = new (_reclaimer.alloc(iThread)) Node(inValue);
                 int backoff = 256;
                 do {
                         Memory::write_barrier();
@@ -70,6 +83,8 @@ public:
 
         PtrNode<T>* remove(final int iThread, PtrNode<T>* final inPtr) {
                 final FCIntPtr inValue = (FCIntPtr) inPtr;
+                //the guard also rules out ABA on _top: curr_top can't be reused while we hold it
+                typename EpochReclaimer<Node>::Guard guard(_reclaimer, iThread);
 
                 int backoff = 256;
                 do {
@@ -80,7 +95,9 @@ public:
 
                         if( _top.compareAndSet(curr_top, curr_top->_next)) {
                                 Memory::read_barrier();
-                                return (PtrNode<T>*) curr_top->_value;
+                                final FCIntPtr rtrn_value = curr_top->_value;
+                                _reclaimer.retire(iThread, curr_top);
+                                return (PtrNode<T>*) rtrn_value;
                         } 
 
                         for(int w=0; w<backoff; ++ w) {++w; --w;}
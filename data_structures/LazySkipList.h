@@ -16,6 +16,7 @@
 //------------------------------------------------------------------------------
 
 #include "FCBase.h"
+#include "EpochReclaimer.h"
 #include "cpp_framework.h"
 
 using namespace CCP;
@@ -33,15 +34,15 @@ protected://types
                 PtrNode<T>* final               _element;
                 final int                       _top_level;
                 TTASLock                        _lock;
-                VolatileType<Node*> * final     _next;
                 VolatileType<bool>              _is_marked;
                 VolatileType<bool>              _is_fully_linked;
+                //inline, so a node the reclaimer recycles needs no allocation
+                VolatileType<Node*>             _next[_MAX_LEVEL + 1];
 
         public:
                 Node(PtrNode<T>* final theElement) 
                   :     _key(theElement->getkey()),
                         _element(theElement),
-                        _next( new VolatileType<Node*>[_MAX_LEVEL + 1]),
                         _top_level( _MAX_LEVEL ),
                         _is_marked( false ),
                         _is_fully_linked( true )
@@ -53,7 +54,6 @@ protected://types
                 Node(PtrNode<T>* final theElement, final int height) 
                   :     _key(theElement->getkey()), 
                         _element(theElement),
-                        _next( new VolatileType<Node*>[height + 1]),
                         _top_level( height ),
                         _is_marked( false ),
                         _is_fully_linked( false )
@@ -63,7 +63,6 @@ protected://types
                 }
 
         public:
-                ~Node() {delete [] _next;}
                 void Lock() {
                         _lock.lock();
                 }
@@ -82,6 +81,7 @@ protected://fields
         VolatileType<_u64>      _random_seed;
         Node* final             _head;
         Node* final             _tail;
+        EpochReclaimer<Node>    _reclaimer;
 
 protected://methods
         inline_ int randomLevel() {
@@ -143,16 +143,23 @@ protected://methods
 public:
         LazySkipList()
         :       _random_seed( Random::getSeed() | 0x010000 ),
-                _head( new Node( new PtrNode<T>(FCBase<T>::_MIN_INT, null) ) ),
-                _tail( new Node( new PtrNode<T>(FCBase<T>::_MAX_INT, null) ) ) 
+                _head( new (EpochReclaimer<Node>::alloc()) Node( new PtrNode<T>(FCBase<T>::_MIN_INT, null) ) ),
+                _tail( new (EpochReclaimer<Node>::alloc()) Node( new PtrNode<T>(FCBase<T>::_MAX_INT, null) ) ),
+                _reclaimer(FCBase<T>::_NUM_THREADS)
         {
                 for (int iLevel = 0; iLevel < _head->_top_level; ++iLevel)
                         _head->_next[iLevel] = _tail;
         }
 
         ~LazySkipList() {
-                delete _head;
-                delete _tail;
+                Node* curr = _head->_next[0];
+                while(_tail != curr) {
+                        Node* final next = curr->_next[0];
+                        EpochReclaimer<Node>::destroy(curr);
+                        curr = next;
+                }
+                EpochReclaimer<Node>::destroy(_head);
+                EpochReclaimer<Node>::destroy(_tail);
         }
 
         //general .....................................................
@@ -160,6 +167,7 @@ public:
                 final FCIntPtr inKey = inPtr->getkey();
                 HPtr preds[_MAX_LEVEL + 1];
                 HPtr succs[_MAX_LEVEL + 1];
+                typename EpochReclaimer<Node>::Guard guard(_reclaimer, iThread);
 
                 while (true) {
                         final int level_found = find(inKey, preds, succs, null);
@@ -191,7 +199,7 @@ public:
                                 }
                                 continue;
                         }
-                        Node* new_node = new Node(inPtr, top_level);
+                        Node* new_node = new (_reclaimer.alloc(iThread)) Node(inPtr, top_level);
 
                         // first link succs
                         for (int level = 0; level < top_level; ++level) {
@@ -216,6 +224,7 @@ public:
         }
 
         PtrNode<T>* remove(final int iThread, PtrNode<T>* final inPtr) {
+                typename EpochReclaimer<Node>::Guard guard(_reclaimer, iThread);
                 while (true) {
                         HPtr remove_node = _head->_next[0];
                         remove_node->Lock();
@@ -264,13 +273,15 @@ public:
                         remove_node->Unlock();
 
 			PtrNode<T>* rv = remove_node->_element;
-			//delete remove_node;
+                        //adders that picked it as a pred may still lock it
+                        _reclaimer.retire(iThread, remove_node);
                         return rv;
                 }
         }
 
         PtrNode<T>* contain(final int iThread, PtrNode<T>* final inPtr) {
                 //peek
+                typename EpochReclaimer<Node>::Guard guard(_reclaimer, iThread);
                 while (true) {
                         HPtr remove_node;
                         remove_node = _head->_next[0];
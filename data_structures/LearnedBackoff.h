@@ -0,0 +1,140 @@
+#ifndef __LEARNED_BACKOFF__
+#define __LEARNED_BACKOFF__
+
+////////////////////////////////////////////////////////////////////////////////
+// File    : LearnedBackoff.h
+// Author  : agent   email: agent@local
+// Written : 19 October 2026
+//
+// Exponential backoff for the CAS retry loops of the lock-free baselines
+// whose base and cap are two knobs ("backoff_base", "backoff_cap", 0..12)
+// tuned by the LearningEngine.
+// The owning data structure calls begin() at the start of each operation,
+// backoff() after each failed CAS and end() once the operation is done (this
+// reports completed operations to the Monitor in batches).
+//
+// Copyright (C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+////////////////////////////////////////////////////////////////////////////////
+// TODO:
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "cpp_framework.h"
+#include "LearningEngine.h"
+#include "Monitor.h"
+
+using namespace CCP;
+
+template <bool _AUTO_TUNE = true, bool _AUTO_REWARD = true>
+class LearnedBackoff {
+private:
+
+        //constants -----------------------------------
+        static final int          _MAX_KNOB       = 12;
+        static final int          _BASE_UNIT_NS   = 16;
+        static final int          _MAX_BACKOFF_NS = (1 << 20);
+        static final int          _REWARD_BATCH   = 64;
+
+        //inner classes -------------------------------
+        struct ThreadInfo {
+                int               _ops      ATTRIBUTE_CACHE_ALIGNED;
+                int               _base;
+                int               _cap;
+                int               _curr;
+                char              _pad      ATTRIBUTE_CACHE_ALIGNED;
+        };
+
+        //fields --------------------------------------
+        final int                 _NUM_THREADS     ATTRIBUTE_CACHE_ALIGNED;
+        Monitor*                  _mon;
+        LearningEngine*           _learner;
+        int                       _tune_ids[2];    //base, cap
+        ThreadInfo*               _thread_info;
+        char                      _pad             ATTRIBUTE_CACHE_ALIGNED;
+
+public:
+        static final int          _NUM_TUNE_KNOBS = 2;    //base, cap
+
+        //public operations ---------------------------
+        LearnedBackoff(final int num_threads, Monitor* mon, LearningEngine* learner)
+        :       _NUM_THREADS(num_threads),
+                _mon(mon),
+                _learner(learner)
+        {
+                _tune_ids[0] = _tune_ids[1] = 0;
+                if ( _AUTO_TUNE ) {
+                        _tune_ids[0] = _learner->register_knob("backoff_base", 0, _MAX_KNOB);
+                        _tune_ids[1] = _learner->register_knob("backoff_cap", 0, _MAX_KNOB);
+                }
+
+                _thread_info = (ThreadInfo*) Memory::byte_aligned_malloc(_NUM_THREADS*sizeof(ThreadInfo), CACHE_LINE_SIZE);
+                for (int i=0; i<_NUM_THREADS; ++i) {
+                        _thread_info[i]._ops = 0;
+                        _thread_info[i]._base = 0;
+                        _thread_info[i]._cap = 0;
+                        _thread_info[i]._curr = 0;
+                }
+
+                Memory::read_write_barrier();
+        }
+
+        ~LearnedBackoff() {
+                Memory::byte_aligned_free(_thread_info);
+        }
+
+        //start of an operation. refresh the knobs and reset the backoff
+        inline_ void begin(final int iThread) {
+                if ( !_AUTO_TUNE )
+                        return;
+
+                ThreadInfo& info = _thread_info[iThread];
+                int knob[2];
+                _learner->tunedvals(iThread, ++info._ops, 2, _tune_ids, knob, _MAX_KNOB, true);
+                final int base = knob[0];
+                final int cap = knob[1];
+
+                info._base = (0 == base) ? 0 : (_BASE_UNIT_NS << (base-1));
+                info._cap = info._base << cap;
+                if ( info._cap > _MAX_BACKOFF_NS )
+                        info._cap = _MAX_BACKOFF_NS;
+                info._curr = info._base;
+        }
+
+        //end of an operation
+        inline_ void end(final int iThread) {
+                if ( _AUTO_TUNE && _AUTO_REWARD )
+                        _mon->addbatchedreward(iThread, _thread_info[iThread]._ops, _REWARD_BATCH);
+        }
+
+        //after a failed CAS
+        inline_ void backoff(final int iThread) {
+                if ( !_AUTO_TUNE )
+                        return;
+
+                ThreadInfo& info = _thread_info[iThread];
+                if ( 0 == info._curr )
+                        return;
+
+                Thread::delay(info._curr);
+                info._curr <<= 1;
+                if ( info._curr > info._cap )
+                        info._curr = info._cap;
+        }
+
+};
+
+#endif
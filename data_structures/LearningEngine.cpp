@@ -25,10 +25,9 @@
 volatile unsigned int         LearningEngine::refcount       = 0;
 volatile unsigned int         LearningEngine::htlock         = 0;
 volatile unsigned int         LearningEngine::signalquit     = 0;
-volatile unsigned int         LearningEngine::lelock         = 0;
-volatile unsigned int         LearningEngine::lelistpos      = 0;
-std::vector<LearningEngine*>  LearningEngine::lelist;
-pthread_t                     LearningEngine::managerthread;
-volatile _u64                 LearningEngine::learnercount   = 0;
+bool                          LearningEngine::helpersrunning = false;
+LearningEngine::Shard         LearningEngine::shards[LearningEngine::MAX_HELPERS];
+unsigned int                  LearningEngine::numhelpers     = 1;
+char                          LearningEngine::policydir[1024] = ".";
 
 
@@ -26,12 +26,15 @@
 
 #include <assert.h>
 #include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <vector>
+#include <algorithm>
 #include <math.h>
 #include "Monitor.h"
 #include "rl_agent_c.h"
+#include "Tuner.h"
 #include "cpp_framework.h"
 #include "portable_defns.h"
 
@@ -53,13 +56,58 @@ public:
                 scancount_tuning       = 0x4,  //if set, use a learned scancount setting
                 manual_stepping        = 0x8,  //if set, no helper thread; require manual stepping
                 inject_sleep           = 0x10, //if set, inject sleep each rl step
-                inject_delay           = 0x20  //if set, inject delay time each rl step
+                inject_delay           = 0x20, //if set, inject delay time each rl step
+                lock_alg_tuning        = 0x40, //if set, SmartLockLite learns its lock algorithm (one more discrete knob)
+                bandit_tuning          = 0x80, //if set, learn with the cheap BanditTuner instead of the NAC
+                policy_freezing        = 0x100 //if set, stop exploring once the reward settles (see isfrozen)
+        };
+
+        //load features a structure can report (see reportstate)
+        enum state_feat_t {
+                feat_active_threads    = 0,    //threads currently using the structure
+                feat_batch_size        = 1,    //operations per combining pass
+                feat_queue_length      = 2,    //elements held
+                num_reported_feats     = 3
+        };
+
+        //what the learner maximizes (see setreward)
+        enum reward_mode_t {
+                reward_throughput      = 0,    //monitor reward per second
+                reward_latency         = 1,    //minus the log of a latency percentile
+                reward_weighted        = 2     //log throughput traded against log latency
         };
 
 private:
 
         friend void* learningengine(void *);
 
+        static final unsigned int MAX_HELPERS        = 64;
+        static final int          SEGMENT_SLOTS      = 64;
+
+        //a run of learner slots. learners claim a free slot with a CAS and
+        //leave by clearing it; when every slot is taken a new segment is
+        //CASed onto next. segments stay until the last learner is gone
+        struct Segment {
+                LearningEngine* volatile     slots[SEGMENT_SLOTS]       ATTRIBUTE_CACHE_ALIGNED;
+                volatile _u64                due[SEGMENT_SLOTS];        //when the helper wants to see each slot next
+                volatile int                 used;                      //slots at or past this were never claimed
+                Segment* volatile            next;
+        };
+
+        //a helper thread and the learners it services. the helper sets due
+        //(a learner only resets it for a free slot it is about to take), and
+        //it announces in visiting which learner it is updating so a leaving
+        //learner can wait for it to let go
+        struct Shard {
+                Segment                      first;
+                volatile unsigned int        numlearners                ATTRIBUTE_CACHE_ALIGNED;
+                LearningEngine* volatile     visiting                   ATTRIBUTE_CACHE_ALIGNED;
+                pthread_t                    thread;
+                bool                         pinned;
+                int                          cpu;
+                char                         pad                        ATTRIBUTE_CACHE_ALIGNED;
+        };
+
         //general
         const learning_mode_t mode ATTRIBUTE_CACHE_ALIGNED;
         Monitor*              mon;        
@@ -69,15 +117,20 @@ private:
         static volatile unsigned int        htlock;
         static volatile unsigned int        refcount;
         static volatile unsigned int        signalquit;
-        static volatile unsigned int        lelock;
-        static volatile unsigned int        lelistpos;
-        static std::vector<LearningEngine*> lelist;
-        static volatile _u64                learnercount;
+        static bool                         helpersrunning;   //under htlock
         volatile unsigned int               dellock  ATTRIBUTE_CACHE_ALIGNED;
 
         //threading
-        pthread_attr_t   managerthreadattr  ATTRIBUTE_CACHE_ALIGNED;
-        static pthread_t managerthread;
+        static Shard                        shards[MAX_HELPERS];
+        static unsigned int                 numhelpers;
+        int                                 shard    ATTRIBUTE_CACHE_ALIGNED;
+        Segment*                            seg;
+        int                                 slot;
+
+        //persisted policy
+        static char                         policydir[1024];
+        char                                policyfile[1024];
+        bool                                policy_loaded;
 
         //reward
         double   last_checkpointed_reward   ATTRIBUTE_CACHE_ALIGNED;
@@ -85,6 +138,14 @@ private:
         double   total_reward_ever;
         timespec last_update_timestamp;
 
+        //latency objective (helper thread only, once set up)
+        reward_mode_t reward_mode;
+        double        lat_pct;
+        double        lat_weight;
+        double        last_latency;
+        _u64*         lat_prev;
+        _u64*         lat_window;
+
         //learning
         int                  num_lock_sched ATTRIBUTE_CACHE_ALIGNED;
         int                  num_sc_tune;
@@ -94,13 +155,61 @@ private:
         int*                 disc_vals;
         int*                 ext_disc_vals;
         int*                 ext_perm_vals;
+
+        //knobs (the scancount ids plus whatever register_knob added); the
+        //learner picks an index, the knob's value is lo + index*step
+        static final int     DEFAULT_KNOB_VALS = 13;
+        static final int     MAX_KNOB_VALS     = 64;
+        static final int     KNOB_NAME_LEN     = 32;
+        int*                 knob_nvals;
+        double*              knob_lo;
+        double*              knob_step;
+        char*                knob_names;
+
+        //application priority hints (lock scheduling)
+        int*                 pri_pin;       //-1 unless the thread is pinned
+        int*                 pri_bias;
+        int*                 pri_order;     //scratch for publishperm
+        int*                 pri_key;
+        char*                pri_taken;
+        int                  num_pri_hints;
+        volatile unsigned int hintlock;
         double*              probs;
-        rl_nac_t             r;
+        Tuner*               tuner;
         struct drand48_data  rng_state      ATTRIBUTE_CACHE_ALIGNED;
 
         //slowdown related
         double               rl_to_sleepidle_ratio  ATTRIBUTE_CACHE_ALIGNED;
 
+        //adaptive update rate (helper thread only)
+        static final _u64    NAP_MIN_NS = 1000;
+        static final _u64    NAP_MAX_NS = 10000000;
+        double               reward_mean    ATTRIBUTE_CACHE_ALIGNED;
+        double               reward_var;
+        int                  reward_samples;
+        _u64                 nap_ns;
+
+        //convergence (policy_freezing). frozen is read by the structures
+        static final int     FREEZE_UPDATES = 256;   //updates the tuner must look converged for
+        static final int     DRIFT_UPDATES  = 4;     //drifted rewards in a row before thawing
+        int                  settled_updates;
+        int                  drift_updates;
+        double               frozen_mean;
+        double               frozen_dev;
+        volatile int         frozen         ATTRIBUTE_CACHE_ALIGNED;
+
+        //tunedvals: who is drawing new values for the structures' own threads
+        static final int     SAMPLE_PERIOD  = 0x100; //calls per thread between draws
+        volatile unsigned int samplelock    ATTRIBUTE_CACHE_ALIGNED;
+
+        //load features: a constant, the monitor's update rate, then what the
+        //structures report. the helper scales each by its recent maximum
+        static final int     NUM_STATE_FEATS = 2 + num_reported_feats;
+        volatile double      reported[num_reported_feats]  ATTRIBUTE_CACHE_ALIGNED;
+        double               statefeats[NUM_STATE_FEATS]   ATTRIBUTE_CACHE_ALIGNED;
+        double               feat_scale[NUM_STATE_FEATS];
+        double               change_rate;
+
         //padding
         char pad  ATTRIBUTE_CACHE_ALIGNED;
 
@@ -111,43 +220,115 @@ private:
 
         static void lelistAdd(LearningEngine *s)
         {
-                while( (0 != lelock) || !CAS(&lelock, 0, 1) );      
-                lelist.push_back(s);
-                CCP::Memory::read_write_barrier();
-                lelock = 0;
+                Segment* g = &shards[s->shard].first;
+                while( true ) {
+                        for(int i = 0; i < SEGMENT_SLOTS; i++) {
+                                if ( NULL != g->slots[i] )
+                                        continue;
+                                //due right away. reset before the CAS publishes us, so the
+                                //helper never sees us with the last owner's due
+                                g->due[i] = 0;
+                                if ( CAS(&g->slots[i], (LearningEngine*) NULL, s) ) {
+                                        s->seg = g;
+                                        s->slot = i;
+                                        int u;
+                                        while( ((u = g->used) <= i) && !CAS(&g->used, u, i + 1) );
+                                        return;
+                                }
+                        }
+
+                        //full: move on, growing the chain if we are at its end
+                        if ( NULL == g->next ) {
+                                Segment* n = newsegment();
+                                if ( !CAS(&g->next, (Segment*) NULL, n) )
+                                        CCP::Memory::byte_aligned_free(n);
+                        }
+                        g = g->next;
+                }
         }
 
         static void lelistRemove(LearningEngine *s)
         {
-                while( (0 != lelock) || !CAS(&lelock, 0, 1) );      
-                std::vector<LearningEngine*>::iterator it = lelist.begin();
-                while(*it != s)
-                        it++;
-                lelist.erase(it);
+                Shard& sh = shards[s->shard];
+                s->seg->slots[s->slot] = NULL;
                 CCP::Memory::read_write_barrier();
-                lelock = 0;
+
+                //the helper may have picked us just before we left
+                while( s == sh.visiting )
+                        CCP::Thread::yield();
         }
-  
-        static LearningEngine* lelistNext()
+
+        //the live learner that is due soonest, announced in sh.visiting (the
+        //caller clears it when done). NULL if there are none
+        static LearningEngine* lelistNext(Shard& sh, Segment*& seg, int& slot)
         {
-               while( (0 != lelock) || !CAS(&lelock, 0, 1) );     
-               if ( lelist.size() == 0 )
-               {
-                       CCP::Memory::read_write_barrier();
-                       lelock = 0;
-                       return NULL;
-               }
+                while( true ) {
+                        seg = NULL;
+                        slot = -1;
+                        for(Segment* g = &sh.first; NULL != g; g = g->next) {
+                                int used = g->used;
+                                for(int i = 0; i < used; i++) {
+                                        if ( (NULL != g->slots[i]) && ((NULL == seg) || (g->due[i] < seg->due[slot])) ) {
+                                                seg = g;
+                                                slot = i;
+                                        }
+                                }
+                        }
+                        if ( NULL == seg )
+                                return NULL;
+
+                        LearningEngine* le = seg->slots[slot];
+                        sh.visiting = le;
+                        CCP::Memory::read_write_barrier();
+                        if ( (NULL != le) && (le == seg->slots[slot]) )
+                                return le;
+                        sh.visiting = NULL;
+                }
+        }
 
-               if ( lelistpos >= lelist.size() )
-                       lelistpos = 0;
+        static Segment* newsegment()
+        {
+                Segment* g = (Segment*) CCP::Memory::byte_aligned_malloc(sizeof(Segment), CACHE_LINE_SIZE);
+                for(int i = 0; i < SEGMENT_SLOTS; i++)
+                        g->slots[i] = NULL;
+                g->used = 0;
+                g->next = NULL;
+                return g;
+        }
 
-               LearningEngine *sl = lelist[lelistpos];
-               lelistpos++;
+        //only once no learner is registered and the helpers have exited
+        static void freesegments()
+        {
+                for(unsigned int i = 0; i < MAX_HELPERS; i++) {
+                        Segment* g = shards[i].first.next;
+                        shards[i].first.next = NULL;
+                        while( NULL != g ) {
+                                Segment* n = g->next;
+                                CCP::Memory::byte_aligned_free(g);
+                                g = n;
+                        }
+                }
+        }
 
-               CCP::Memory::read_write_barrier();
-               lelock = 0; 
+        static _u64 nowns()
+        {
+                timespec ts;
+                clock_gettime( CLOCK_MONOTONIC, &ts );
+                return ((_u64) ts.tv_sec) * 1000000000 + ts.tv_nsec;
+        }
 
-               return sl;
+        //the requested helper, or else the one with the fewest learners
+        static int pickshard(int helper)
+        {
+                if ( (helper >= 0) && (helper < numhelpers) )
+                        return helper;
+
+                int best = 0;
+                for(int i = 1; i < numhelpers; i++) {
+                        if ( shards[i].numlearners < shards[best].numlearners )
+                                best = i;
+                }
+                return best;
         }
 
         void registerLearner(LearningEngine *l)
@@ -162,17 +343,24 @@ private:
 
                while( (0 != htlock) || !CAS(&htlock, 0, 1) );
 
-               learnercount += U64(0x0001000000000001);
+               shard = pickshard(shard);
+               shards[shard].numlearners += 1;
 
                //CCP::Memory::read_write_barrier();
 
-               if ( refcount++ == 0 )
+               ++refcount;
+
+               //the first learner that is not stepped by hand starts the helpers,
+               //whatever registered before it
+               if ( !helpersrunning && (0 == (mode & manual_stepping)) )
                {
-                       if ( 0 == (mode & manual_stepping) ) {
-                               pthread_attr_init(&managerthreadattr);
-                               pthread_attr_setdetachstate(&managerthreadattr, PTHREAD_CREATE_JOINABLE);
-                               pthread_create(&managerthread, &managerthreadattr, learningengine, NULL);
-                       }
+                       pthread_attr_t attr;
+                       pthread_attr_init(&attr);
+                       pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+                       for(long i = 0; i < numhelpers; i++)
+                               pthread_create(&shards[i].thread, &attr, learningengine, (void*) i);
+                       pthread_attr_destroy(&attr);
+                       helpersrunning = true;
                }
 
                CCP::Memory::read_write_barrier();
@@ -192,15 +380,20 @@ private:
 
                while( (0 != htlock) || !CAS(&htlock, 0, 1) );
 
-               learnercount += U64(0xFFFF000000000001);     
+               shards[shard].numlearners -= 1;
 
+               //the last learner out stops the helpers, whoever started them,
+               //before the segments they walk are freed
                if ( --refcount == 0 )
                {
-                       if ( 0 == (mode & manual_stepping) ) {
+                       if ( helpersrunning ) {
                               FAADD(&signalquit, 1);
-                              pthread_join(managerthread, NULL);
+                              for(int i = 0; i < numhelpers; i++)
+                                      pthread_join(shards[i].thread, NULL);
                               FAADD(&signalquit, -1);
+                              helpersrunning = false;
                        }
+                       freesegments();
                }
 
                CCP::Memory::read_write_barrier();
@@ -208,6 +401,10 @@ private:
 
                while( (0 != dellock) || !CAS(&dellock, 0, 1) );
 
+               //the helper is done with us; keep what we learned for next time
+               if ( '\0' != policyfile[0] )
+                       writepolicy();
+
                deinitrl();
                deinitAPI();
 
@@ -221,9 +418,10 @@ private:
         //------------------------------------
         inline int clippriority(int pri)
         {
-                //we have 64 discrete priority levels, 0-63, w/ 63 rsvd
+                //SmartLockLite has one level per thread: a single word up to 63
+                //threads, groups of 64 levels beyond that, up to 1024 threads
                 assert( pri >= 0 );
-                return pri < 62 ? pri : 62;
+                return pri < (int) nthreads-1 ? pri : (int) nthreads-1;
         }
 
         //------------------------------------
@@ -239,6 +437,9 @@ private:
                 bool _is_manual_stepping        = (mode & manual_stepping);
                 bool _is_inject_sleep           = (mode & inject_sleep);
                 bool _is_inject_delay           = (mode & inject_delay);
+                bool _is_lock_alg_tuning        = (mode & lock_alg_tuning);
+                bool _is_bandit_tuning          = (mode & bandit_tuning);
+                bool _is_policy_freezing        = (mode & policy_freezing);
 
                 bool err = false;
                 err |= ( _is_random_lock_scheduling && (_is_lock_scheduling ||_is_scancount_tuning || _is_inject_sleep || _is_inject_delay ) );
@@ -248,6 +449,10 @@ private:
                 err |= ( ( rl_to_sleepidle_ratio < .0001 ) || ( rl_to_sleepidle_ratio > 1.0 ) );
                 err |= ( _is_lock_scheduling && (num_lock_sched < 1) );
                 err |= ( _is_scancount_tuning && (num_sc_tune < 1) );
+                err |= ( _is_lock_alg_tuning && !_is_scancount_tuning );
+                err |= ( _is_bandit_tuning && !( _is_lock_scheduling || _is_scancount_tuning ) );
+                err |= ( _is_bandit_tuning && ( _is_inject_sleep || _is_inject_delay ) );
+                err |= ( _is_policy_freezing && !( _is_lock_scheduling || _is_scancount_tuning ) );
 
                 if ( err ) {
                         cerr << "Sorry, unsupported mode: " << mode << endl;
@@ -263,14 +468,25 @@ private:
                 perm_vals     = (int*) CCP::Memory::byte_aligned_malloc(permbytes, CACHE_LINE_SIZE);
                 ext_perm_vals = (int*) CCP::Memory::byte_aligned_malloc(permbytes, CACHE_LINE_SIZE);
 
+                //perm_vals is the learned order; thread i publishes priority nthreads-1-perm_vals[i]
+                for (int i = 0; i<nthreads; ++i) {
+                        perm_vals[i] = i;
+                        ext_perm_vals[i] = clippriority( nthreads - 1 - i );
+                }
+
+                pri_pin   = new int[nthreads];
+                pri_bias  = new int[nthreads];
+                pri_order = new int[nthreads];
+                pri_key   = new int[nthreads];
+                pri_taken = new char[nthreads];
                 for (int i = 0; i<nthreads; ++i) {
-                        int p = clippriority( nthreads - 1 - i );
-                        perm_vals[i] = p;
-                        ext_perm_vals[i] = p;
+                        pri_pin[i] = -1;
+                        pri_bias[i] = 0;
                 }
+                num_pri_hints = 0;
 
                 assert( num_sc_tune >= 0 );
-                int discbytes = CACHE_LINE_SIZE * num_sc_tune;
+                int discbytes = CACHE_LINE_SIZE * num_sc_tune * sizeof(int);
                 disc_vals     = (int*) CCP::Memory::byte_aligned_malloc(discbytes, CACHE_LINE_SIZE);
                 ext_disc_vals = (int*) CCP::Memory::byte_aligned_malloc(discbytes, CACHE_LINE_SIZE);
 
@@ -278,6 +494,17 @@ private:
                         disc_vals[i*CACHE_LINE_SIZE] = nthreads;
                         ext_disc_vals[i*CACHE_LINE_SIZE] = nthreads;
                 }
+
+                knob_nvals = new int[num_sc_tune];
+                knob_lo    = new double[num_sc_tune];
+                knob_step  = new double[num_sc_tune];
+                knob_names = new char[num_sc_tune * KNOB_NAME_LEN];
+                for (int i = 0; i<num_sc_tune; ++i) {
+                        knob_nvals[i] = DEFAULT_KNOB_VALS;
+                        knob_lo[i] = 0;
+                        knob_step[i] = 1;
+                        knob_names[i*KNOB_NAME_LEN] = '\0';
+                }
         }
 
         void deinitAPI()
@@ -286,6 +513,15 @@ private:
 		CCP::Memory::byte_aligned_free(ext_disc_vals);
 		CCP::Memory::byte_aligned_free(perm_vals);
 		CCP::Memory::byte_aligned_free(ext_perm_vals);
+                delete[] pri_pin;
+                delete[] pri_bias;
+                delete[] pri_order;
+                delete[] pri_key;
+                delete[] pri_taken;
+                delete[] knob_nvals;
+                delete[] knob_lo;
+                delete[] knob_step;
+                delete[] knob_names;
         }
 
         void initrl()
@@ -295,13 +531,41 @@ private:
 
                 probs = new double[nthreads];
                 srand48_r( 42, &rng_state );
+                buildtuner();
+
+                // initialize reward computation stuff
+                reward_mean = 0;
+                reward_var = 0;
+                reward_samples = 0;
+                nap_ns = 0;
+                settled_updates = 0;
+                drift_updates = 0;
+                frozen = 0;
+                last_checkpointed_reward = 0;
+                last_checkpointed_changes = 0;
+                total_reward_ever = 0;
+                last_update_timestamp = rlgettime();
+
+                change_rate = 0;
+                for(int i = 0; i < NUM_STATE_FEATS; i++) {
+                        statefeats[i] = 0;
+                        feat_scale[i] = 0;
+                }
+                statefeats[0] = 1.;
+                for(int i = 0; i < num_reported_feats; i++)
+                        reported[i] = 0;
+        }
+
+        void buildtuner()
+        {
+                tuner = NULL;
 
                 //cerr << "In initrl with mode=" << mode << endl;
 
                 if ( (mode & lock_scheduling) && (mode & scancount_tuning) )
                 {
                         //cerr << "Configuring ml for both" << endl;
-                        //nthreads perm vals, 1 discrete (range 0 to 12)
+                        //nthreads perm vals, 1 discrete per knob (range 0 to 12 unless registered otherwise)
 		        rl_act_entry_t* raes = new rl_act_entry_t[ 1+num_sc_tune ];
                         raes[0].type = RLA_PERM;
                         raes[0].first_param = nthreads;
@@ -309,11 +573,11 @@ private:
                         for(int i = 0; i < num_sc_tune; i++) {
 			        raes[1+i].type = RLA_DISCRETE;
 				raes[1+i].first_param = 1;
-				raes[1+i].second_param = 13;
+				raes[1+i].second_param = knob_nvals[i];
 				raes[1+i].vals = &disc_vals[i*CACHE_LINE_SIZE];
 			}
                         rl_act_desc_t rad = { 1+num_sc_tune, raes };
-                        r = rl_nac_init( 1, &rad, rl_to_sleepidle_ratio );
+                        tuner = newtuner( &rad );
                         delete[] raes;
 #if 0
                         rl_act_entry_t raes[] = 
@@ -328,16 +592,16 @@ private:
                 }     
                 else if ( mode & scancount_tuning ) {
                         //cerr << "Configuring ml for external discrete" << endl;
-                        //0 perm vals, 1 discrete (range 0 to 12)
+                        //0 perm vals, 1 discrete per knob (range 0 to 12 unless registered otherwise)
 		        rl_act_entry_t* raes = new rl_act_entry_t[ num_sc_tune ];
                         for(int i = 0; i < num_sc_tune; i++) {
 			        raes[i].type = RLA_DISCRETE;
 				raes[i].first_param = 1;
-				raes[i].second_param = 13;
+				raes[i].second_param = knob_nvals[i];
 				raes[i].vals = &disc_vals[i*CACHE_LINE_SIZE];
 			}
                         rl_act_desc_t rad = { num_sc_tune, raes };
-                        r = rl_nac_init( 1, &rad, rl_to_sleepidle_ratio );
+                        tuner = newtuner( &rad );
                         delete[] raes;
 #if 0
                         rl_act_entry_t raes[] = 
@@ -355,14 +619,171 @@ private:
                         raes[0].first_param = nthreads;
                         rl_act_desc_t rad = { 1, raes };
 
-                        r = rl_nac_init( 1, &rad, rl_to_sleepidle_ratio );
+                        tuner = newtuner( &rad );
                 }
+        }
 
-                // initialize reward computation stuff
-                last_checkpointed_reward = 0;
-                last_checkpointed_changes = 0;
-                total_reward_ever = 0;
-                last_update_timestamp = rlgettime();
+        //a knob's range changed the shape of the actions, so the tuner has to
+        //be rebuilt (forgetting what it learned so far)
+        void rebuildtuner()
+        {
+                while( (0 != dellock) || !CAS(&dellock, 0, 1) );
+                frozen = 0;
+                settled_updates = 0;
+                delete tuner;
+                buildtuner();
+                CCP::Memory::read_write_barrier();
+                dellock = 0;
+        }
+
+        int addknob(const char* name, double lo, double step, int nvals)
+        {
+                //knobs are learned alongside the scancounts and share their ids
+                assert( mode & scancount_tuning );
+                assert( (nvals >= 2) && (nvals <= MAX_KNOB_VALS) );
+
+                int id = register_sc_tune_id();
+                assert( id < num_sc_tune );
+
+                knob_lo[id] = lo;
+                knob_step[id] = step;
+                snprintf(&knob_names[id*KNOB_NAME_LEN], KNOB_NAME_LEN, "%s", (NULL != name) ? name : "");
+
+                //a warm-start policy already holds this knob's value
+                if ( (knob_nvals[id] == nvals) && policy_loaded )
+                        return id;
+
+                disc_vals[id*CACHE_LINE_SIZE] = 0;
+                ext_disc_vals[id*CACHE_LINE_SIZE] = 0;
+
+                if ( knob_nvals[id] != nvals ) {
+                        //reshaping the tuner throws a loaded policy away
+                        if ( policy_loaded )
+                                cerr << "Discarding the policy in " << policyfile << ": knob " << id
+                                     << " now has " << nvals << " values, not " << knob_nvals[id] << endl;
+                        policy_loaded = false;
+                        knob_nvals[id] = nvals;
+                        rebuildtuner();
+                }
+                return id;
+        }
+
+        inline int knobindex(unsigned int id)
+        {
+                int i = ext_disc_vals[CACHE_LINE_SIZE * id];
+                if ( i < 0 )
+                        return 0;
+                return (i < knob_nvals[id]) ? i : knob_nvals[id] - 1;
+        }
+
+        //policy file: a header that must match this learner, the knobs'
+        //ranges, the published values, then the tuner's parameters. written
+        //to a temporary file and renamed so a concurrent reader never sees
+        //half of it
+        bool writepolicy()
+        {
+                char tmp[1024+16];
+                snprintf(tmp, sizeof(tmp), "%s.%d", policyfile, (int) getpid());
+                FILE* f = fopen(tmp, "w");
+                if ( NULL == f )
+                        return false;
+
+                fprintf(f, "smartds-policy 4\n%d %d %d %d %d\n", (int) mode, nthreads, num_lock_sched, num_sc_tune, (int) reward_mode);
+                fprintf(f, "nvals");
+                for(int i = 0; i < num_sc_tune; i++)
+                        fprintf(f, " %d", knob_nvals[i]);
+                fprintf(f, "\nperm");
+                for(int i = 0; i < nthreads; i++)
+                        fprintf(f, " %d", perm_vals[i]);
+                fprintf(f, "\ndisc");
+                for(int i = 0; i < num_sc_tune; i++)
+                        fprintf(f, " %d", disc_vals[i*CACHE_LINE_SIZE]);
+                fprintf(f, "\n");
+                if ( NULL != tuner )
+                        tuner->save(f);
+
+                bool ok = !ferror(f);
+                ok &= (0 == fclose(f));
+                ok = ok && (0 == rename(tmp, policyfile));
+                if ( !ok )
+                        unlink(tmp);
+                return ok;
+        }
+
+        bool readpolicy()
+        {
+                FILE* f = fopen(policyfile, "r");
+                if ( NULL == f )
+                        return false;
+
+                int version, fmode, fthreads, flock, fsc, freward;
+                bool ok = (1 == fscanf(f, " smartds-policy %d", &version)) && (4 == version);
+                ok = ok && (5 == fscanf(f, "%d %d %d %d %d", &fmode, &fthreads, &flock, &fsc, &freward));
+                ok = ok && (fmode == mode) && (fthreads == nthreads) && (flock == num_lock_sched) && (fsc == num_sc_tune);
+                ok = ok && (freward == reward_mode);
+
+                //knobs registered so far must have the saved ranges. the rest
+                //take them, since their structures register them after warmstart
+                int* nvals = new int[num_sc_tune + 1];
+                bool reshape = false;
+                int at = -1;
+                ok = ok && (0 == fscanf(f, " nvals%n", &at)) && (at > 0);
+                for(int i = 0; ok && (i < num_sc_tune); i++) {
+                        ok = (1 == fscanf(f, "%d", &nvals[i])) && (nvals[i] >= 2) && (nvals[i] <= MAX_KNOB_VALS);
+                        ok = ok && ((i >= sc_tune_id) || (nvals[i] == knob_nvals[i]));
+                        reshape |= ok && (nvals[i] != knob_nvals[i]);
+                }
+
+                //each thread appears in the permutation exactly once
+                int* perm = new int[nthreads];
+                bool* seen = new bool[nthreads];
+                for(int i = 0; i < nthreads; i++)
+                        seen[i] = false;
+                at = -1;
+                ok = ok && (0 == fscanf(f, " perm%n", &at)) && (at > 0);
+                for(int i = 0; ok && (i < nthreads); i++) {
+                        ok = (1 == fscanf(f, "%d", &perm[i])) && (perm[i] >= 0) && (perm[i] < nthreads) && !seen[perm[i]];
+                        if ( ok )
+                                seen[perm[i]] = true;
+                }
+
+                int* disc = new int[num_sc_tune + 1];
+                at = -1;
+                ok = ok && (0 == fscanf(f, " disc%n", &at)) && (at > 0);
+                for(int i = 0; ok && (i < num_sc_tune); i++)
+                        ok = (1 == fscanf(f, "%d", &disc[i])) && (disc[i] >= 0) && (disc[i] < nvals[i]);
+
+                //the tuner's parameters are shaped by the ranges
+                if ( ok && reshape ) {
+                        for(int i = 0; i < num_sc_tune; i++)
+                                knob_nvals[i] = nvals[i];
+                        rebuildtuner();
+                }
+                ok = ok && ((NULL == tuner) || tuner->load(f));
+                fclose(f);
+
+                if ( ok ) {
+                        for(int i = 0; i < nthreads; i++)
+                                perm_vals[i] = perm[i];
+                        for(int i = 0; i < num_sc_tune; i++) {
+                                disc_vals[i*CACHE_LINE_SIZE] = disc[i];
+                                ext_disc_vals[i*CACHE_LINE_SIZE] = disc[i];
+                        }
+                        publishperm();
+                        policy_loaded = true;
+                }
+                delete[] nvals;
+                delete[] seen;
+                delete[] perm;
+                delete[] disc;
+                return ok;
+        }
+
+        Tuner* newtuner(rl_act_desc_t *rad)
+        {
+                if ( mode & bandit_tuning )
+                        return new BanditTuner( rad, NUM_STATE_FEATS );
+                return new NacTuner( NUM_STATE_FEATS, rad, rl_to_sleepidle_ratio );
         }
 
         void deinitrl()
@@ -375,7 +796,7 @@ private:
                 delete[] probs;
 
                 if ( mode & (lock_scheduling | scancount_tuning) )
-                        rl_nac_deinit( r );
+                        delete tuner;
         }
    
         timespec rlgettime()
@@ -418,9 +839,10 @@ private:
                 return false;
         }
 #else
+        //don't wait for the monitor to change; rlupdate naps instead
         double getmonitorsignal(_u64& changes)
         {
-                return mon ? mon->waitchangenotsafe(changes) : 0;
+                return mon ? mon->getrewardnotsafe(changes) : 0;
         }
 
         bool getreward( double *reward ) 
@@ -444,6 +866,7 @@ private:
                         last_update_timestamp = tmp_time;
                         double r = accumulated_heartbeats / time_elapsed;
                         *reward = r;
+                        change_rate = accumulated_changes / time_elapsed;
                         //cerr << "reward= " << r << endl;
                         last_checkpointed_reward = total_reward_ever;
                         last_checkpointed_changes = total_changes_ever;
@@ -454,39 +877,264 @@ private:
         }
 #endif
 
-        void rlupdate() 
+        //one learning step. returns how long the helper may leave us alone:
+        //our nap, which is short while the reward moves and long while it is
+        //steady or the structure is idle, so busy learners get most of the
+        //helper's time
+        _u64 rlupdate() 
         {
                 //cerr << "running rl update" << endl;
                 //ML policy
 
 	        if ( !CAS(&dellock, 0, 1) )
-		        return;
+		        return NAP_MIN_NS;
 
-                _u64 start_seq_no = (learnercount & U64(0xFFFFFFFFFFFF));
-                _u64 status;
-                _u64 num_live;
-                _u64 seq_no;
-
-                do
                 {
                         double reward;
                         if ( getreward( &reward ) )
                         {
 			        //getsample();
+                                learn( reward );
+                        }
+                        else if ( nap_ns < NAP_MAX_NS )
+                        {
+                                //nothing new from the monitor; the application is idle or slow
+                                nap_ns = (nap_ns < NAP_MIN_NS) ? NAP_MIN_NS : (nap_ns << 1);
+                        }
+                }
 
-                                double statefeats[] = {1.};
-                                rl_nac_update( r, reward, statefeats );
+                _u64 nap = nap_ns;
+                CCP::Memory::read_write_barrier();
+                dellock = 0;                
+                return nap;
+        }
+
+        //one step on a reward rate; dellock held
+        void learn(double reward)
+        {
+                if ( frozen ) {
+                        //a sample in flight when we froze may have overwritten the greedy values
+                        if ( 1 == frozen ) {
+                                publishgreedy();
+                                frozen = 2;
+                        }
+                        checkdrift( reward );
+                } else {
+                        collectstate();
+                        tuner->update( objective( reward ), statefeats );
+                        adaptrate( reward );
+                        if ( mode & policy_freezing ) {
+                                settled_updates = tuner->converged() ? settled_updates + 1 : 0;
+                                if ( settled_updates >= FREEZE_UPDATES )
+                                        freeze();
                         }
-                        //cerr << "looping in rlupdate." << endl;
+                }
+        }
+
+        //the reward handed to the tuner for a window that ran at throughput.
+        //latency is the chosen percentile over the operations that finished
+        //since the previous window (the previous value if none did). logs keep
+        //the two on a common, unitless scale
+        double objective(double throughput)
+        {
+                if ( reward_throughput == reward_mode )
+                        return throughput;
+
+                if ( mon->getlatencyhist(lat_window) ) {
+                        for(int b = 0; b < Monitor::LATENCY_BUCKETS; b++) {
+                                _u64 now = lat_window[b];
+                                lat_window[b] = now - lat_prev[b];
+                                lat_prev[b] = now;
+                        }
+                        double lat = Monitor::histpercentile(lat_window, lat_pct);
+                        if ( lat > 0 )
+                                last_latency = lat;
+                }
 
-                        status = learnercount;
-                        num_live = (status >> 48);
-                        seq_no = (status & U64(0xFFFFFFFFFFFF));
+                double cost = log(1. + last_latency);
+                if ( reward_latency == reward_mode )
+                        return -cost;
+                return (1. - lat_weight) * log(1. + throughput) - lat_weight * cost;
+        }
 
-                } while( (0 == (mode & manual_stepping)) && (num_live == 1) && (seq_no == start_seq_no) );
+        //refresh statefeats. each feature is divided by the largest value it
+        //took recently (the maximum decays so it follows a shrinking load too)
+        void collectstate()
+        {
+                statefeats[1] = change_rate;
+                for(int i = 0; i < num_reported_feats; i++)
+                        statefeats[2+i] = reported[i];
+
+                for(int i = 1; i < NUM_STATE_FEATS; i++) {
+                        double v = fabs(statefeats[i]);
+                        feat_scale[i] *= .999;
+                        if ( v > feat_scale[i] )
+                                feat_scale[i] = v;
+                        statefeats[i] = (feat_scale[i] > 0) ? v / feat_scale[i] : 0;
+                }
+        }
+
+        //update rate: back off while the reward is steady and go back to full
+        //speed when it jumps (a new phase or a change in the workload)
+        void adaptrate(double reward)
+        {
+                final double alpha  = 1. / 16;  //weight of the newest reward
+                final double steady = .05;      //stddev under 5% of the mean
+                final double jump   = .25;      //moved by over 25% and 3 stddevs
+
+                if ( 0 == reward_samples++ ) {
+                        reward_mean = reward;
+                        reward_var = 0;
+                        return;
+                }
+
+                double d = reward - reward_mean;
+                double scale = fabs(reward_mean);
+                if ( (reward_samples > 16) && (fabs(d) > jump * scale) && (d * d > 9 * reward_var) ) {
+                        reward_samples = 1;
+                        reward_mean = reward;
+                        reward_var = 0;
+                        nap_ns = 0;
+                        return;
+                }
+
+                reward_mean += alpha * d;
+                reward_var = (1 - alpha) * (reward_var + alpha * d * d);
+
+                if ( reward_var < steady * steady * scale * scale ) {
+                        if ( nap_ns < NAP_MAX_NS )
+                                nap_ns = (nap_ns < NAP_MIN_NS) ? NAP_MIN_NS : (nap_ns << 1);
+                } else {
+                        nap_ns >>= 1;
+                }
+        }
+
+        //the tuner has stopped changing its mind: publish the greedy policy and
+        //stop sampling. the helper keeps reading the reward at the slowest rate
+        void freeze()
+        {
+                frozen_mean = reward_mean;
+                frozen_dev = sqrt(reward_var);
+                drift_updates = 0;
 
+                frozen = 1;
                 CCP::Memory::read_write_barrier();
-                dellock = 0;                
+                publishgreedy();
+
+                nap_ns = NAP_MAX_NS;
+        }
+
+        void publishgreedy()
+        {
+                tuner->greedy();
+                for(int i = 0; i < num_sc_tune; i++)
+                        ext_disc_vals[i*CACHE_LINE_SIZE] = disc_vals[i*CACHE_LINE_SIZE];
+                publishperm();
+        }
+
+        //thaw once the reward moved (same test as adaptrate's jump) a few
+        //times in a row; learning then resumes from the frozen policy
+        void checkdrift(double reward)
+        {
+                final double jump = .25;
+
+                double d = fabs(reward - frozen_mean);
+                if ( (d <= jump * fabs(frozen_mean)) || (d <= 3 * frozen_dev) ) {
+                        drift_updates = 0;
+                        return;
+                }
+                if ( ++drift_updates < DRIFT_UPDATES )
+                        return;
+
+                reward_samples = 0;
+                settled_updates = 0;
+                nap_ns = 0;
+                CCP::Memory::read_write_barrier();
+                frozen = 0;
+        }
+
+        //orders the unpinned threads by biased priority, then by learned priority
+        struct HintOrder {
+                const int* key;
+                const int* perm;
+                HintOrder(const int* k, const int* p): key(k), perm(p) {}
+                bool operator()(int a, int b) const
+                {
+                        if ( key[a] != key[b] )
+                                return key[a] > key[b];
+                        return perm[a] < perm[b];
+                }
+        };
+
+        //publish the order in perm_vals as priorities. pinned threads get their
+        //pinned priority; the others share what is left, ranked by learned
+        //priority plus bias, so the result stays a permutation
+        void publishperm()
+        {
+                while( (0 != hintlock) || !CAS(&hintlock, 0, 1) );
+
+                if ( 0 == num_pri_hints ) {
+                        for(int i = 0; i < nthreads; ++i)
+                                ext_perm_vals[i] = clippriority(nthreads - 1 - perm_vals[i]);
+                } else {
+                        int n = 0;
+                        for(int i = 0; i < nthreads; ++i)
+                                pri_taken[i] = 0;
+                        for(int i = 0; i < nthreads; ++i) {
+                                if ( pri_pin[i] >= 0 ) {
+                                        pri_taken[pri_pin[i]] = 1;
+                                        ext_perm_vals[i] = clippriority(pri_pin[i]);
+                                } else {
+                                        pri_key[i] = (nthreads - 1 - perm_vals[i]) + pri_bias[i];
+                                        pri_order[n++] = i;
+                                }
+                        }
+
+                        std::sort(pri_order, pri_order + n, HintOrder(pri_key, perm_vals));
+
+                        int p = nthreads - 1;
+                        for(int k = 0; k < n; ++k) {
+                                while( pri_taken[p] )
+                                        p--;
+                                ext_perm_vals[pri_order[k]] = clippriority(p--);
+                        }
+                }
+
+                CCP::Memory::read_write_barrier();
+                hintlock = 0;
+        }
+
+        void setpriorityhint(unsigned int tid, int pin, int bias)
+        {
+                if ( mode == disabled )
+                        return;
+
+                assert( tid < nthreads );
+                if ( pin >= (int) nthreads )
+                        pin = nthreads - 1;
+
+                while( (0 != hintlock) || !CAS(&hintlock, 0, 1) );
+
+                //one thread per priority: a newer pin displaces an older one
+                if ( pin >= 0 ) {
+                        for(int i = 0; i < nthreads; ++i) {
+                                if ( (i != tid) && (pri_pin[i] == pin) ) {
+                                        pri_pin[i] = -1;
+                                        if ( 0 == pri_bias[i] )
+                                                num_pri_hints--;
+                                }
+                        }
+                }
+
+                bool had = (pri_pin[tid] >= 0) || (0 != pri_bias[tid]);
+                bool has = (pin >= 0) || (0 != bias);
+                pri_pin[tid] = pin;
+                pri_bias[tid] = bias;
+                num_pri_hints += (int) has - (int) had;
+                CCP::Memory::read_write_barrier();
+                hintlock = 0;
+
+                publishperm();
         }
 
         // given a multinomial probability vector, sample an index
@@ -505,14 +1153,30 @@ private:
                 return nthreads - 1;
         }
 
-        void randupdate() 
+        //a fresh random priority order. returns our nap, like rlupdate
+        _u64 randupdate() 
         {
                 //cerr << "calling rand update" << endl;
 
                 // random policy
 
 	        if ( !CAS(&dellock, 0, 1) )
-		        return;
+		        return NAP_MIN_NS;
+
+                //reshuffle while the structure makes progress; back off while it is idle
+                _u64 changes = last_checkpointed_changes;
+                if ( NULL != mon )
+                        mon->getrewardnotsafe( changes );
+                if ( (NULL != mon) && (changes == last_checkpointed_changes) ) {
+                        if ( nap_ns < NAP_MAX_NS )
+                                nap_ns = (nap_ns < NAP_MIN_NS) ? NAP_MIN_NS : (nap_ns << 1);
+                        _u64 nap = nap_ns;
+                        CCP::Memory::read_write_barrier();
+                        dellock = 0;
+                        return nap;
+                }
+                last_checkpointed_changes = changes;
+                nap_ns = NAP_MIN_NS;
 
                 // initialize them all equally likely (adjusted for initial renormalizing)
                 for(int i = 0; i < nthreads; i++)
@@ -527,15 +1191,18 @@ private:
 
                         // sample and set priority
                         int a = sample( probs, &rng_state );
-                        ext_perm_vals[a] = clippriority( priority );
+                        perm_vals[a] = nthreads - 1 - priority;
 
                         // clear out the chosen one; set next sum
                         probs[a] = 0.;
                         sum = ((double) priority) / (priority + 1);        
                 }
 
+                publishperm();
+
                 CCP::Memory::read_write_barrier();
                 dellock = 0; 
+                return NAP_MIN_NS;
         }
 
 
@@ -547,18 +1214,31 @@ private:
         //---------------------
 
          LearningEngine(unsigned int threads, Monitor *m, double rlfactor = 1.0, 
-                        learning_mode_t mode = disabled, int num_lock_scheduling = 0, int num_scancount_tuning = 0 )
-        :  nthreads(threads), 
+                        learning_mode_t mode = disabled, int num_lock_scheduling = 0, int num_scancount_tuning = 0,
+                        int helper = -1 )
+        :  mode(mode),
            mon(m), 
-           mode(mode),
-           rl_to_sleepidle_ratio(rlfactor),
+           nthreads(threads), 
+	   dellock(0),
+           shard(helper),
+           reward_mode(reward_throughput),
+           lat_pct(.99),
+           lat_weight(.5),
+           last_latency(0),
+           lat_prev(NULL),
+           lat_window(NULL),
            num_lock_sched(num_lock_scheduling),
            num_sc_tune(num_scancount_tuning),
            lock_sched_id(0),
 	   sc_tune_id(0),
-	   dellock(0)
+           hintlock(0),
+           rl_to_sleepidle_ratio(rlfactor)
         {
 	        //cerr << "instantiated a learner. num_sc_tune= " << num_sc_tune << endl;
+                policyfile[0] = '\0';
+                policy_loaded = false;
+                frozen = 0;
+                samplelock = 0;
                 modeCheck();
                 registerLearner(this);
         }
@@ -566,22 +1246,25 @@ private:
         ~LearningEngine() 
         {
                 unregisterLearner(this);
+                delete[] lat_prev;
+                delete[] lat_window;
         }
 
         void getsample() {
-                rl_nac_action_sample( r );
+                if ( !frozen )
+                        tuner->sample();
 
                 //output the vals
                 for(int i = 0; i < num_sc_tune; i++)
 		        ext_disc_vals[i*CACHE_LINE_SIZE] = disc_vals[i*CACHE_LINE_SIZE];
 
-                for(int i = 0; i < nthreads; ++i)
-                        ext_perm_vals[i] = clippriority(nthreads - 1 - perm_vals[i]);
+                publishperm();
                 //cerr << "scancount = " << disc_vals[0] << endl;
 	}
 
         int samplediscval(int sc_tune_id) {
-	        rl_nac_action_sample_individual( r, num_lock_sched + sc_tune_id );
+                if ( !frozen )
+	                tuner->sample( num_lock_sched + sc_tune_id );
                 int rv = disc_vals[CACHE_LINE_SIZE * sc_tune_id];
                 ext_disc_vals[CACHE_LINE_SIZE * sc_tune_id] = rv;
                 return rv;  
@@ -600,22 +1283,242 @@ private:
 		return id;
 	}
 
+        //general knobs. any structure can expose a parameter for online tuning;
+        //the learner needs one scancount slot (num_scancount_tuning) per knob
+        //and scancount_tuning in its mode. register while the structure is
+        //being set up, before threads sample. an integer knob takes the values
+        //lo..hi (at most 64 of them)
+        int register_knob(const char* name, int lo, int hi)
+        {
+                return addknob(name, lo, 1, hi - lo + 1);
+        }
+
+        //a real-valued knob in [lo, hi], learned over steps evenly spaced values
+        int register_real_knob(const char* name, double lo, double hi, int steps = DEFAULT_KNOB_VALS)
+        {
+                return addknob(name, lo, (hi - lo) / (steps - 1), steps);
+        }
+
+        inline int getknob(unsigned int knob_id, unsigned int tid)
+        {
+                return (int) floor(getknobval(knob_id, tid) + .5);
+        }
+
+        inline double getknobval(unsigned int knob_id, unsigned int tid)
+        {
+                return knob_lo[knob_id] + knob_step[knob_id] * knobindex(knob_id);
+        }
+
+        //draw a new value; same locking rules as samplediscval
+        int sampleknob(unsigned int knob_id)
+        {
+                samplediscval(knob_id);
+                return getknob(knob_id, 0);
+        }
+
+        //for structures whose own threads tune them (no combiner to take
+        //turns): the values of ids[0..n) for thread tid, clipped to 0..hi.
+        //ops counts the calling thread's operations; once every SAMPLE_PERIOD
+        //of them the thread tries to draw new values. drawing touches shared
+        //learner state, so one thread draws at a time and the others read the
+        //published values. knobs selects register_knob ids over scancount ids
+        void tunedvals(unsigned int tid, int ops, int n, const int* ids, int* vals, int hi, bool knobs = false)
+        {
+                bool draw = (0 == (ops & (SAMPLE_PERIOD-1))) && (0 == samplelock) && CAS(&samplelock, 0, 1);
+                for(int i = 0; i < n; i++) {
+                        int v;
+                        if ( draw )
+                                v = knobs ? sampleknob(ids[i]) : samplediscval(ids[i]);
+                        else
+                                v = knobs ? getknob(ids[i], tid) : getdiscval(ids[i], tid);
+                        vals[i] = (v < 0) ? 0 : ((v > hi) ? hi : v);
+                }
+                if ( draw ) {
+                        CCP::Memory::read_write_barrier();
+                        samplelock = 0;
+                }
+        }
+
+        const char* getknobname(unsigned int knob_id)
+        {
+                return &knob_names[knob_id*KNOB_NAME_LEN];
+        }
+
+        //optimize latency instead of throughput. needs a monitor that measures
+        //latency (LatencyMonitor). reward_latency minimizes the latency at
+        //percentile pct (.99 is p99); reward_weighted maximizes
+        //(1-weight)*log(throughput) - weight*log(latency). call before the
+        //threads using the learner start (and before warmstart: policies are
+        //only reused for the same objective); returns false if the monitor
+        //can't supply latencies
+        bool setreward(reward_mode_t rmode, double pct = .99, double weight = .5)
+        {
+                assert( (pct > 0) && (pct <= 1) && (weight >= 0) && (weight <= 1) );
+
+                if ( reward_throughput != rmode ) {
+                        if ( NULL == lat_prev ) {
+                                lat_prev = new _u64[Monitor::LATENCY_BUCKETS];
+                                lat_window = new _u64[Monitor::LATENCY_BUCKETS];
+                        }
+                        if ( (NULL == mon) || !mon->getlatencyhist(lat_prev) )
+                                return false;
+                }
+
+                last_latency = 0;
+                lat_pct = pct;
+                lat_weight = weight;
+                CCP::Memory::read_write_barrier();
+                reward_mode = rmode;
+                return true;
+        }
+
+        //load feature feat of the structure(s) using this learner is now
+        //value. a plain store, so report from one thread at a time (e.g. the
+        //combiner) and not on every operation
+        inline void reportstate(state_feat_t feat, double value)
+        {
+                reported[feat] = value;
+        }
+
         inline int getdiscval(unsigned int sc_tune_id, unsigned int tid)
         {
                 return ext_disc_vals[CACHE_LINE_SIZE * sc_tune_id];
         }
 
+        //set a scancount value by hand, e.g. to replay a setting under
+        //manual_stepping. it holds until the next draw
+        inline void setdiscval(unsigned int sc_tune_id, int val)
+        {
+                disc_vals[CACHE_LINE_SIZE * sc_tune_id] = val;
+                ext_disc_vals[CACHE_LINE_SIZE * sc_tune_id] = val;
+        }
+
         inline int getpermval(unsigned int lock_sched_id, unsigned int tid)
         {
 	        //FIXME. this will need to change when we support > 1 perm obj
                 return ext_perm_vals[tid];
         }
 
+        //application priority hints for lock scheduling (higher priority wins).
+        //a pinned thread always gets priority pri; pinning a second thread to
+        //the same pri unpins the first (it keeps any bias). a bias shifts a
+        //thread's learned priority before the unpinned threads are ranked.
+        //hints apply right away and stay in force across learning updates
+        void pinpriority(unsigned int tid, int pri)
+        {
+                setpriorityhint(tid, (pri < 0) ? 0 : pri, 0);
+        }
+
+        void biaspriority(unsigned int tid, int bias)
+        {
+                setpriorityhint(tid, -1, bias);
+        }
+
+        void clearpriorityhint(unsigned int tid)
+        {
+                setpriorityhint(tid, -1, 0);
+        }
+
+        //helper threads. by default one helper services every learner; with
+        //more, each learner is owned by one helper (chosen by the helper
+        //argument of the constructor, else the least loaded one), so e.g. one
+        //helper per socket can tune the structures used on that socket.
+        //cpus, if given, pins helper i to cpus[i]. call while no learners
+        //exist; returns false and changes nothing if some do (their helpers
+        //are running) or n isn't 1..64
+        static bool sethelpers(unsigned int n, const int* cpus = NULL)
+        {
+                if ( (0 == n) || (n > MAX_HELPERS) )
+                        return false;
+
+                while( (0 != htlock) || !CAS(&htlock, 0, 1) );
+                bool ok = (0 == refcount);
+                if ( ok ) {
+                        numhelpers = n;
+                        for(int i = 0; i < n; i++) {
+                                shards[i].pinned = (NULL != cpus);
+                                shards[i].cpu = (NULL != cpus) ? cpus[i] : -1;
+                        }
+                }
+                CCP::Memory::read_write_barrier();
+                htlock = 0;
+                return ok;
+        }
+
+        static unsigned int gethelpers()
+        {
+                return numhelpers;
+        }
+
+        inline int gethelper()
+        {
+                return shard;
+        }
+
+        //warm start: remember where this learner's policy lives (keyed by
+        //name, e.g. the structure it tunes, and the thread count) and load it
+        //if a previous run left one behind. returns whether it loaded. the
+        //policy is saved again when the learner is destroyed. call before
+        //the threads using the learner start. knobs not yet registered take
+        //the ranges the policy was saved with; registering one later with a
+        //different range discards the policy (and says so on stderr)
+        bool warmstart(const char* name)
+        {
+                if ( mode == disabled )
+                        return false;
+                snprintf(policyfile, sizeof(policyfile), "%s/%s.%u.policy", policydir, name, nthreads);
+                return readpolicy();
+        }
+
+        //save now (e.g. periodically) rather than only at destruction
+        bool savepolicy()
+        {
+                return ('\0' != policyfile[0]) && writepolicy();
+        }
+
+        //where warmstart keeps policy files (default: the working directory)
+        static void setpolicydir(const char* dir)
+        {
+                snprintf(policydir, sizeof(policydir), "%s", dir);
+        }
+
         inline learning_mode_t getmode()
         {
                 return mode;
         }
 
+        //with manual_stepping the application runs the learning steps the
+        //helper thread would, e.g. from a control loop of its own. step() learns
+        //from the monitor's reward since the last step; step(reward) from a
+        //reward rate the application measured itself. both return how long the
+        //helper would nap before the next step, in ns
+        _u64 step()
+        {
+                assert( mode & manual_stepping );
+                if ( mode & random_lock_scheduling )
+                        return randupdate();
+                return rlupdate();
+        }
+
+        _u64 step(double reward)
+        {
+                assert( (mode & manual_stepping) && (mode & (lock_scheduling | scancount_tuning)) );
+                while( (0 != dellock) || !CAS(&dellock, 0, 1) );
+                learn( reward );
+                _u64 nap = nap_ns;
+                CCP::Memory::read_write_barrier();
+                dellock = 0;
+                return nap;
+        }
+
+        //with policy_freezing: whether the learner found a policy it is happy
+        //with. while frozen it publishes that policy's greedy values, sampling
+        //returns them unchanged, and the helper only watches the reward
+        inline bool isfrozen()
+        {
+                return 0 != frozen;
+        }
+
 };
 
 
@@ -624,22 +1527,59 @@ private:
 //Learning Helper Thread
 //------------------------------
 
-static void* learningengine(void *)
+static void* learningengine(void *arg)
 {
+        LearningEngine::Shard& sh = LearningEngine::shards[(long) arg];
+
+#ifdef __linux__
+        if ( sh.pinned ) {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                CPU_SET(sh.cpu, &cpus);
+                pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        }
+#endif
+
         // get this valid, up-to-date in our cache
         LearningEngine::signalquit = FAADD(&LearningEngine::signalquit, 0);
 
+        _u64 idle_ns = 0;
+
         while( 0 == LearningEngine::signalquit )
         {
-                // get next live lock (or retry)
-                LearningEngine *le = LearningEngine::lelistNext();
-                if ( le == NULL )
+                // get the learner due soonest (or park with backoff until one registers)
+                LearningEngine::Segment *seg;
+                int slot;
+                LearningEngine *le = LearningEngine::lelistNext(sh, seg, slot);
+                if ( le == NULL ) {
+                        if ( idle_ns < LearningEngine::NAP_MAX_NS )
+                                idle_ns = (idle_ns < LearningEngine::NAP_MIN_NS) ? LearningEngine::NAP_MIN_NS : (idle_ns << 1);
+                        CCP::Thread::sleep(idle_ns / 1000000, idle_ns % 1000000);
+                        continue;
+                }
+                idle_ns = 0;
+
+                // not due yet: nobody is, so sleep until it is
+                _u64 now = LearningEngine::nowns();
+                _u64 due = seg->due[slot];
+                if ( due > now ) {
+                        sh.visiting = NULL;
+                        _u64 ns = due - now;
+                        if ( ns > LearningEngine::NAP_MAX_NS )
+                                ns = LearningEngine::NAP_MAX_NS;
+                        CCP::Thread::sleep(ns / 1000000, ns % 1000000);
                         continue;
-      
+                }
+
+                _u64 nap;
                 if ( le->mode == LearningEngine::random_lock_scheduling )
-                        le->randupdate();
+                        nap = le->randupdate();
                 else
-                        le->rlupdate();
+                        nap = le->rlupdate();
+                seg->due[slot] = now + nap;
+
+                CCP::Memory::read_write_barrier();
+                sh.visiting = NULL;
         }
 
         return NULL;
@@ -29,10 +29,14 @@
 
 #include "FCBase.h"
 #include "cpp_framework.h"
+#include "EpochReclaimer.h"
+#include "LearnedBackoff.h"
 
 using namespace CCP;
 
-template <class T> class MSQueue  : public FCBase<T> {
+//with _AUTO_TUNE, failed CASes on the list back off by a learned amount
+template <class T, bool _AUTO_TUNE = false, bool _AUTO_REWARD = false> 
+class MSQueue  : public FCBase<T> {
 private:
 
         struct Node {
@@ -44,11 +48,19 @@ private:
 
         AtomicStampedReference<Node>    _head;
         AtomicStampedReference<Node>    _tail;
+        EpochReclaimer<Node>            _reclaimer;
+        LearnedBackoff<_AUTO_TUNE,_AUTO_REWARD> _backoff;
 
 public:
-        MSQueue() {
+        static final int      _NUM_TUNE_KNOBS          = LearnedBackoff<_AUTO_TUNE,_AUTO_REWARD>::_NUM_TUNE_KNOBS;
+        static final boolean  _REWARDS_FROM_ANY_THREAD = true;
+
+        MSQueue(Monitor* mon = null, LearningEngine* learner = null) 
+        : _reclaimer(FCBase<T>::_NUM_THREADS),
+          _backoff(FCBase<T>::_NUM_THREADS, mon, learner)
+        {
                 // Allocate a free node
-                Node* const new_node = new Node(FCBase<T>::_NULL_VALUE);
+                Node* const new_node = new (EpochReclaimer<Node>::alloc()) Node(FCBase<T>::_NULL_VALUE);
 
                 // Make it the only node in the linked list
                 new_node->_next.set(null,0);
@@ -56,14 +68,25 @@ public:
                 _tail.set(new_node,0);
         }
 
+        ~MSQueue() {
+                Node* curr = _head.getReference();
+                while(null != curr) {
+                        Node* final next = curr->_next.getReference();
+                        EpochReclaimer<Node>::destroy(curr);
+                        curr = next;
+                }
+        }
+
         boolean add(final int iThread, PtrNode<T>* final inPtr) { 
                 final FCIntPtr inValue = (FCIntPtr) inPtr;
 
                 CasInfo& my_cas_info = FCBase<T>::_cas_info_ary[iThread];
+                typename EpochReclaimer<Node>::Guard guard(_reclaimer, iThread);
+                _backoff.begin(iThread);
 
                 // Allocate a new node from the free list
                 // Set next pointer of node to NULL
-                Node* new_node = new Node(inValue);                             
+                Node* new_node = new (_reclaimer.alloc(iThread)) Node(inValue);                             
                 new_node->_next.set(null, 0);          
                 
                 AtomicStampedReference<Node> tail;
@@ -88,6 +111,7 @@ public:
                                                 break;  
                                         } else {
                                                 ++(my_cas_info._failed);
+                                                _backoff.backoff(iThread);
                                         }
                                 } else {                
                                         // Tail was not pointing to the last node Try to swing Tail to the next node
@@ -106,6 +130,7 @@ public:
                         ++(my_cas_info._failed);
 
                 ++(my_cas_info._ops);
+                _backoff.end(iThread);
                 return true;
         }
 
@@ -113,6 +138,8 @@ public:
                 final FCIntPtr inValue = (FCIntPtr) inPtr;
 
                 CasInfo& my_cas_info = FCBase<T>::_cas_info_ary[iThread];
+                typename EpochReclaimer<Node>::Guard guard(_reclaimer, iThread);
+                _backoff.begin(iThread);
 
                 AtomicStampedReference<Node> head;
                 AtomicStampedReference<Node> tail;
@@ -133,6 +160,7 @@ public:
                                         // Is queue empty?
                                         if (null == next.getReference()) {                                       
                                                 ++(my_cas_info._ops);
+                                                _backoff.end(iThread);
                                                 // Queue is empty, couldn't dequeue
                                                 return FCBase<T>::_NULL_VALUE; 
                                         }
@@ -150,13 +178,15 @@ public:
                                         // Try to swing Head to the next node
                                         if (_head.compareAndSet(head.getReference(), next.getReference(), head.getStamp(), head.getStamp()+1)) {
                                                 ++(my_cas_info._succ);
-                                                // It is safe now to free the old node
-                                                //free(head.ptr)                     
+                                                // Free the old node once no one can still be reading it
+                                                _reclaimer.retire(iThread, head.getReference());
                                                 ++(my_cas_info._ops);
+                                                _backoff.end(iThread);
                                                 // Queue was not empty, dequeue succeeded  
                                                 return (PtrNode<T>*) rtrn_value;     
                                         } else {
                                                 ++(my_cas_info._failed);
+                                                _backoff.backoff(iThread);
                                         }
                                 }
                         }
@@ -173,7 +203,7 @@ public:
         }
 
         const char* name() {
-                return "MSQueue";
+                return _AUTO_TUNE ? "SmartMSQueue" : "MSQueue";
         }
 
 };
@@ -37,7 +37,7 @@ template <class T> class OyamaQueue : public FCBase<T> {
 private:
 
         struct Node {
-                const FCIntPtr      _value;
+                FCIntPtr            _value;
                 Node* volatile      _next;
 
                 Node(final FCIntPtr x) : _value(x) {
@@ -45,17 +45,32 @@ private:
                 }
         };
 
+        //one per thread, reused for every operation. a thread has at most one
+        //request in the log and only returns once it has been answered
         struct Req {
-                VolatileType<FCIntPtr> _req_ans;
-                int                    _d1,d2,d3,d4;
+                VolatileType<FCIntPtr> _req_ans  ATTRIBUTE_CACHE_ALIGNED;
+                char                   _pad      ATTRIBUTE_CACHE_ALIGNED;
 
-                Req(final FCIntPtr in_req) : _req_ans(in_req) { }
+                Req() : _req_ans(FCBase<T>::_NULL_VALUE) { }
         };
 
         AtomicInteger           _log_lock;
         QueueForLogSync<Req>    _log;
         Node* volatile          _head;
         Node* volatile          _tail;
+        Req*                    _req_ary;
+
+        //dequeued nodes for reuse. only the combiner touches it
+        Node*                   _free_nodes;
+
+        inline_ Node* alloc_node(final FCIntPtr x) {
+                Node* const new_node = _free_nodes;
+                if(null == new_node)
+                        return new Node(x);
+                _free_nodes = new_node->_next;
+                new_node->_value = x;
+                return new_node;
+        }
 
         void execute_log(CasInfo& my_cas_info) {
                 for (int i=0; i<FCBase<T>::_NUM_THREADS; ++i) {
@@ -65,14 +80,13 @@ private:
 
                         final FCIntPtr req_ans = curr_req->_req_ans;
                         if(req_ans > FCBase<T>::_NULL_VALUE) {
-                                Node* const new_node = new Node(req_ans);       // Allocate a new node from the free list
+                                Node* const new_node = alloc_node(req_ans);     // Allocate a new node from the free list
                                 new_node->_next = null;                         // Set next pointer of node to NULL
 
                                 _tail->_next = new_node;                        // Link node at the end of the linked list
                                 _tail = new_node;                               // Swing Tail to node
 
                                  curr_req->_req_ans = FCBase<T>::_NULL_VALUE;
-                                 //delete curr_req;
 
                         } else if(FCBase<T>::_DEQ_VALUE == req_ans) {
 
@@ -84,9 +98,10 @@ private:
                                 } else {
                                         final FCIntPtr curr_value = new_head->_value;      // Queue not empty.  Read value before release
                                         _head = new_head;                                       // Swing Head to next node
+                                        old_head->_next = _free_nodes;                          // Recycle the old dummy
+                                        _free_nodes = old_head;
                                         curr_req->_req_ans = -(curr_value);
                                 }
-                                //delete curr_req;
                         }
                 }
         }
@@ -96,12 +111,31 @@ public:
                 Node* const new_node = new Node(FCBase<T>::_NULL_VALUE);
                 new_node->_next = null;
                 _head = _tail = new_node;
+                _free_nodes = null;
+                _req_ary = new Req[FCBase<T>::_NUM_THREADS];
+        }
+
+        ~OyamaQueue() {
+                Node* curr = _head;
+                while(null != curr) {
+                        Node* const next = curr->_next;
+                        delete curr;
+                        curr = next;
+                }
+                curr = _free_nodes;
+                while(null != curr) {
+                        Node* const next = curr->_next;
+                        delete curr;
+                        curr = next;
+                }
+                delete[] _req_ary;
         }
 
         boolean add(final int iThread, PtrNode<T>* final inPtr) { 
                 final FCIntPtr inValue = (FCIntPtr) inPtr;
 
-                Req* final my_req( new Req(inValue) );
+                Req* final my_req = &_req_ary[iThread];
+                my_req->_req_ans = inValue;
                 CasInfo& my_cas_info = FCBase<T>::_cas_info_ary[iThread];
                 _log.enq(my_req, my_cas_info);
 
@@ -121,7 +155,8 @@ public:
                                         FCBase<T>::thread_wait(iThread);
                                 } 
                                 Memory::read_barrier();
-                                if(FCBase<T>::_NULL_VALUE !=  my_req->_req_ans) {
+                                //answered: the record is out of the log and may be reused
+                                if(FCBase<T>::_NULL_VALUE == my_req->_req_ans) {
                                         ++(my_cas_info._ops);
                                         return true;
                                 }
@@ -132,7 +167,8 @@ public:
         PtrNode<T>* remove(final int iThread, PtrNode<T>* final inPtr) { 
                 final FCIntPtr inValue = (FCIntPtr) inPtr;
 
-                Req* final my_req( new Req(FCBase<T>::_DEQ_VALUE) );
+                Req* final my_req = &_req_ary[iThread];
+                my_req->_req_ans = FCBase<T>::_DEQ_VALUE;
                 CasInfo& my_cas_info = FCBase<T>::_cas_info_ary[iThread];
                 _log.enq(my_req, my_cas_info);
 
@@ -175,10 +175,23 @@ public:
                 return (null == _root);
         }
 
+        //only valid when the heap is not empty
+        FCIntPtr minKey() {
+                return _root->_key;
+        }
+
         void makeEmpty() {
                 _root = null;
         }
 
+        static final char* name_fc() {
+                return "FCPairHeap";
+        }
+
+        static final char* name_smart() {
+                return "SmartPairHeap";
+        }
+
 
 };
 
@@ -60,7 +60,7 @@ private:
 
         struct Node {
                 Node* volatile  _next;
-                _T* final       _value;
+                _T*             _value;
 
                 Node(_T* final x) : _value(x) {}
         };
@@ -70,11 +70,53 @@ private:
         VolatileType<Node*>     _head;
         VolatileType<Node*>     _tail;
 
+        //nodes released by deq() for enq() to reuse. deq() is only called by
+        //the current combiner and pops happen under _tail_lock, so there is at
+        //most one pusher and one popper at a time and a popped node can't come
+        //back while a pop is in flight (no ABA)
+        Node* volatile          _free_nodes;
+
+        //call with _tail_lock held
+        inline_ Node* alloc_node(_T* final x) {
+                Node* new_node;
+                do {
+                        new_node = _free_nodes;
+                        if(null == new_node)
+                                return new Node(x);
+                } while(!CAS(&_free_nodes, new_node, new_node->_next));
+                new_node->_value = x;
+                return new_node;
+        }
+
+        inline_ void free_node(Node* final old_node) {
+                Node* top;
+                do {
+                        top = _free_nodes;
+                        old_node->_next = top;
+                } while(!CAS(&_free_nodes, top, old_node));
+        }
+
 public:
         QueueForLogSync() {
                 Node* const new_node = new Node(null);                  // Allocate a free node
                 new_node->_next = null;                                 // Make it the only node in the linked list
                 _head = _tail = new_node;                               // Both Head and Tail point to it
+                _free_nodes = null;
+        }
+
+        ~QueueForLogSync() {
+                Node* curr = _head;
+                while(null != curr) {
+                        Node* final next = curr->_next;
+                        delete curr;
+                        curr = next;
+                }
+                curr = _free_nodes;
+                while(null != curr) {
+                        Node* final next = curr->_next;
+                        delete curr;
+                        curr = next;
+                }
         }
 
         void pass_predict() {
@@ -90,11 +132,11 @@ public:
 
         boolean enq(_T* final inValue, CasInfo& in_cas_info) {
 
-                Node* const new_node = new Node(inValue);               // Allocate a new node from the free list
-                new_node->_next = null;                                 // Set next pointer of node to NULL
-
                 _tail_lock.lock(in_cas_info);                           // Acquire T_lock in order to access Tail
 
+                Node* const new_node = alloc_node(inValue);             // Allocate a new node from the free list
+                new_node->_next = null;                                 // Set next pointer of node to NULL
+
                 _tail->_next = new_node;                                // Link node at the end of the linked list
                 _tail = new_node;                                       // Swing Tail to node
 
@@ -112,6 +154,7 @@ public:
 
                 _T* final curr_value = new_head->_value;                // Queue not empty.  Read value before release
                 _head = new_head;                                       // Swing Head to next node
+                free_node(old_head);                                    // Old dummy is unreachable now
                 return curr_value;                                      // Queue was not empty, dequeue succeeded
         }
 
@@ -0,0 +1,160 @@
+
+#ifndef __SMARTLOCK__
+#define __SMARTLOCK__
+
+////////////////////////////////////////////////////////////////////////////////
+// File    : SmartLock.h
+// Author  : agent   email: agent@local
+// Written : 19 October 2026
+//
+// Application-facing SmartLock for arbitrary critical sections. It wraps a
+// SmartLockLite with plain lock/unlock/try_lock and a scoped Guard. Like the
+// rest of the library, callers identify themselves with a thread id in
+// [0, threads).
+//
+// To get learned lock scheduling either hand it a LearningEngine created
+// with lock_scheduling (a LearningEngine currently schedules one lock), or
+// hand it just a Monitor and the SmartLock makes and owns such a learner.
+// Either way the reward is whatever the application reports to the Monitor
+// (e.g. Hb::addreward per unit of work), so the learned priorities are the
+// ones that make the application faster, not the lock.
+// Threads that must not queue behind the learned schedule (say, request
+// serving threads) can be pinned to a priority or biased; the learner then
+// only orders the rest.
+//
+// Usage:
+//      SmartLock lock(num_threads, monitor);
+//      ...
+//      {
+//              SmartLock::Guard g(lock, iThread);
+//              ... critical section ...
+//      }
+//
+// Copyright (C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+////////////////////////////////////////////////////////////////////////////////
+
+#include "LearningEngine.h"
+#include "Monitor.h"
+#include "SmartLockLite.h"
+#include "cpp_framework.h"
+#include "portable_defns.h"
+
+
+using namespace std;
+
+
+class SmartLock
+{
+private:
+
+        SmartLockLite<int>*  sll      ATTRIBUTE_CACHE_ALIGNED;
+        LearningEngine*      learner;
+        bool                 ownlearner;
+
+        char pad[CACHE_LINE_SIZE];
+
+        //not copyable
+        SmartLock(const SmartLock&);
+        SmartLock& operator=(const SmartLock&);
+
+public:
+
+        //scoped critical section
+        class Guard {
+                SmartLock&    _lock;
+                final int     _id;
+
+                Guard(const Guard&);
+                Guard& operator=(const Guard&);
+        public:
+                Guard(SmartLock& l, final int id) : _lock(l), _id(id) { _lock.lock(_id); }
+                ~Guard() { _lock.unlock(_id); }
+        };
+
+        //no learning; behaves like a TTAS lock
+        SmartLock(unsigned int threads): learner(NULL), ownlearner(false)
+        {
+                sll = new SmartLockLite<int>(threads, NULL);
+                CCP::Memory::read_write_barrier();
+        }
+
+        //share a learner the caller created (with lock_scheduling to learn priorities)
+        SmartLock(unsigned int threads, LearningEngine *le): learner(le), ownlearner(false)
+        {
+                sll = new SmartLockLite<int>(threads, le);
+                CCP::Memory::read_write_barrier();
+        }
+
+        //learn priorities against the reward the application gives mon
+        SmartLock(unsigned int threads, Monitor *mon, double rl_to_sleepidle_ratio = 1.0): ownlearner(true)
+        {
+                learner = new LearningEngine(threads, mon, rl_to_sleepidle_ratio, LearningEngine::lock_scheduling, 1, 0);
+                sll = new SmartLockLite<int>(threads, learner);
+                CCP::Memory::read_write_barrier();
+        }
+
+        ~SmartLock()
+        {
+                delete sll;
+                if ( ownlearner )
+                        delete learner;
+                CCP::Memory::read_write_barrier();
+        }
+
+        void lock(unsigned int id)
+        {
+                sll->lock(id);
+        }
+
+        //one attempt, in line with the algorithm's policy (a PRLOCK waiter with
+        //higher priority present makes this fail without touching the lock)
+        bool try_lock(unsigned int id)
+        {
+                //an already-"answered" abort condition makes SmartLockLite give up after one try
+                volatile int gaveup = 1;
+                return sll->lock(&gaveup, 0, id);
+        }
+
+        void unlock(unsigned int id)
+        {
+                sll->unlock(id);
+        }
+
+        //keep latency-critical threads ahead of the learned schedule (pin) or
+        //nudge them (bias); the learner orders everybody else
+        void pinpriority(unsigned int id, int pri)
+        {
+                sll->pinpriority(id, pri);
+        }
+
+        void biaspriority(unsigned int id, int bias)
+        {
+                sll->biaspriority(id, bias);
+        }
+
+        void clearpriorityhint(unsigned int id)
+        {
+                sll->clearpriorityhint(id);
+        }
+
+        LearningEngine* getlearner()
+        {
+                return learner;
+        }
+};
+
+#endif
@@ -26,8 +26,13 @@
 
 #define CASSTATS
 
+//define LOCKSTATS (e.g. -DLOCKSTATS) to keep per-thread wait and hold time
+//histograms and per-priority acquisition counts in every SmartLockLite
+//#define LOCKSTATS
+
 
 #include <assert.h>
+#include <stdio.h>
 #include "LearningEngine.h"
 #include "cpp_framework.h"
 #include "portable_defns.h"
@@ -40,6 +45,29 @@ using namespace std;
 //#endif
 
 
+// SmartLocks Lite queue lock node
+// The QUEUE algorithm lines waiters up MCS style so that only the head of
+// the queue polls fastprlock; everyone else spins on its own node. A waiter
+// whose request gets answered while queued abandons its node, and whoever
+// hands the queue to an abandoned node passes it on and frees the node.
+
+struct SmartLockLiteQNode
+{
+        enum qstate_t {
+                QFREE,
+                QWAITING,
+                QGRANTED,
+                QABANDONED
+        };
+
+        SmartLockLiteQNode* volatile next    ATTRIBUTE_CACHE_ALIGNED;
+        volatile unsigned int        state;
+        char                         pad     ATTRIBUTE_CACHE_ALIGNED;
+
+        SmartLockLiteQNode(): next(NULL), state(QFREE) {}
+};
+
+
 // SmartLocks Lite State
 
 class SmartLockLiteState
@@ -48,19 +76,47 @@ private:
 
         template<typename T> friend class SmartLockLiteNode;
 
+        //one group word per cache line
+        static const int PRGROUP_STRIDE = CACHE_LINE_SIZE / sizeof(_u64);
+
+public:
+
+        //the most threads a lock serves, as for the FC structures built on it
+        //(FCBase::_MAX_THREADS). 16 groups; fastprlock has room for 63
+        static const unsigned int MAX_THREADS = 1024;
+
+private:
+
         volatile _u64 fastprlock             ATTRIBUTE_CACHE_ALIGNED;  
+        SmartLockLiteQNode* volatile qtail   ATTRIBUTE_CACHE_ALIGNED;
+        volatile _u64* prgroups;
         char          pad[CACHE_LINE_SIZE];
 
 public:
  
-        SmartLockLiteState(): fastprlock(0)
+        SmartLockLiteState(): fastprlock(0), qtail(NULL), prgroups(NULL)
         {
                 //cerr << "calling smartlocklitestate constructor" << endl;
                 CCP::Memory::read_write_barrier();
         }
 
         ~SmartLockLiteState() 
-        {}
+        {
+                if ( NULL != prgroups )
+                        CCP::Memory::byte_aligned_free((void*) prgroups);
+        }
+
+        //past 63 threads the priorities don't fit in fastprlock. bits 0-62 of
+        //fastprlock then flag groups of 64 priorities that have a waiter and
+        //each group keeps its own 64-bit word of waiting priorities
+        void init_groups(unsigned int threads)
+        {
+                int ngroups = (threads + 63) / 64;
+                prgroups = (volatile _u64*) CCP::Memory::byte_aligned_malloc(ngroups*PRGROUP_STRIDE*sizeof(_u64), CACHE_LINE_SIZE);
+                for(int i = 0; i < ngroups*PRGROUP_STRIDE; i++)
+                        prgroups[i] = 0;
+                CCP::Memory::read_write_barrier();
+        }
 };
 
 
@@ -71,18 +127,48 @@ class SmartLockLiteNode {
 
 private:
 
+        //an abandoned node stays queued for a while, so keep a few
+        static const int NUM_QNODES = 4;
+        static const unsigned int QUEUE_YIELD_SPINS = 0x3ff;
+
         int              lock_sched_id  ATTRIBUTE_CACHE_ALIGNED;
         volatile _u64*   fastprlock;
+        volatile _u64*   prgroups;
+        SmartLockLiteQNode* volatile* qtail;
         LearningEngine*  learner;
         int              id;
 
         volatile unsigned int  alg ATTRIBUTE_CACHE_ALIGNED;
 
+        SmartLockLiteQNode     qnodes[NUM_QNODES];
+        int                    qnext;
+
 #ifdef CASSTATS
         unsigned int casops ATTRIBUTE_CACHE_ALIGNED;
         unsigned int casfails;
 #endif
 
+#ifdef LOCKSTATS
+public:
+        //bucket b counts times in [2^b, 2^(b+1)) cpu ticks; the last one takes the rest
+        static const int NUM_LOCKSTATS_BUCKETS = 40;
+private:
+        //only written by the owning thread
+        _u64   waithist[NUM_LOCKSTATS_BUCKETS] ATTRIBUTE_CACHE_ALIGNED;
+        _u64   holdhist[NUM_LOCKSTATS_BUCKETS];
+        _u64   acquires;
+        _u64   aborts;
+        tick_t acquiredat;
+
+        static inline int lockstats_bucket(tick_t t)
+        {
+                int b = 0;
+                while( (t >>= 1) && (b < NUM_LOCKSTATS_BUCKETS-1) )
+                        b++;
+                return b;
+        }
+#endif
+
         char pad[CACHE_LINE_SIZE];
 
         inline int get_perm_val(LearningEngine* learner, int lock_sched_id, int id) 
@@ -90,11 +176,48 @@ private:
 	        return (null != learner) ? learner->getpermval(lock_sched_id, id) : id;
 	}
 
+        inline SmartLockLiteQNode* get_free_qnode()
+        {
+                while(true) {
+                        for(int i = 0; i < NUM_QNODES; i++) {
+                                SmartLockLiteQNode* q = &qnodes[qnext];
+                                qnext = (qnext + 1) % NUM_QNODES;
+                                if ( SmartLockLiteQNode::QFREE == q->state )
+                                        return q;
+                        }
+                        //all of ours are still queued behind someone
+                        CCP::Thread::yield();
+                }
+        }
+
+        //hand the head of the queue to the next waiter that still wants it
+        void release_queue(SmartLockLiteQNode* q)
+        {
+                while(true) {
+                        SmartLockLiteQNode* succ = q->next;
+                        if ( NULL == succ ) {
+                                if ( CAS(qtail, q, (SmartLockLiteQNode*) NULL) ) {
+                                        q->state = SmartLockLiteQNode::QFREE;
+                                        return;
+                                }
+                                while( NULL == (succ = q->next) );
+                        }
+                        q->state = SmartLockLiteQNode::QFREE;
+
+                        if ( CAS(&succ->state, SmartLockLiteQNode::QWAITING, SmartLockLiteQNode::QGRANTED) )
+                                return;
+
+                        //succ gave up while queued; release it on its owner's behalf
+                        q = succ;
+                }
+        }
+
 public:
 
         enum algorithm_t {
                 PRLOCK,
                 TTAS,
+                QUEUE,
                 NUM_ALGORITHMS
         };
 
@@ -103,6 +226,9 @@ public:
                 // This constructor will intentionally cause a segfault in your application if object is used
 	        lock_sched_id = 0;
                 fastprlock = NULL;
+                prgroups = NULL;
+                qtail = NULL;
+                qnext = 0;
                 id = 0;
                 learner = NULL;
                 alg = PRLOCK;
@@ -111,6 +237,9 @@ public:
                 casops = 0;
                 casfails = 0;
 #endif
+#ifdef LOCKSTATS
+                resetlockstats();
+#endif
 
                 CCP::Memory::read_write_barrier();
         }   
@@ -119,6 +248,9 @@ public:
         {
 	        lock_sched_id = lsid;
                 fastprlock = &s->fastprlock;
+                prgroups = s->prgroups;
+                qtail = &s->qtail;
+                qnext = 0;
                 id = i;
                 learner = le;
                 alg = a;
@@ -127,6 +259,9 @@ public:
                 casops = 0;
                 casfails = 0;
 #endif
+#ifdef LOCKSTATS
+                resetlockstats();
+#endif
 
                 CCP::Memory::read_write_barrier();
         }
@@ -135,7 +270,21 @@ public:
 
         bool lock(volatile T *ptr, T val)
         {
+#ifdef LOCKSTATS
+                tick_t start = CCP::System::read_cpu_ticks();
+                bool rv = trylock(ptr, val);
+                tick_t now = CCP::System::read_cpu_ticks();
+                if ( rv ) {
+                        waithist[lockstats_bucket(now - start)]++;
+                        acquires++;
+                        acquiredat = now;
+                } else {
+                        aborts++;
+                }
+                return rv;
+#else
                 return trylock(ptr, val);
+#endif
         }
 
         void lock()
@@ -203,6 +352,54 @@ public:
                 return true;
         }
 
+        //must play nicely with trylock_*: the queue only decides which of its
+        //waiters polls fastprlock, the lock itself is still the lockbit
+        bool trylock_queue(volatile T *ptr, T val) //__attribute__ ((noinline))
+        {
+	        const _u64 lockbit = (U64(1) << 63);
+
+                SmartLockLiteQNode* q = get_free_qnode();
+                q->next = NULL;
+                q->state = SmartLockLiteQNode::QWAITING;
+                CCP::Memory::read_write_barrier();
+
+                SmartLockLiteQNode* pred = FASTORE(qtail, q);
+                if ( NULL != pred ) {
+                        pred->next = q;
+                        unsigned int spins = 0;
+                        while( SmartLockLiteQNode::QWAITING == q->state ) {
+                                if ( *ptr != val ) {
+                                        if ( CAS(&q->state, SmartLockLiteQNode::QWAITING, SmartLockLiteQNode::QABANDONED) )
+                                                return false;
+                                }
+                                //a queue is only as fast as its slowest waiter; don't hog a
+                                //core the thread ahead of us may need when oversubscribed
+                                if ( 0 == (++spins & QUEUE_YIELD_SPINS) )
+                                        CCP::Thread::yield();
+                        }
+                }
+
+                //we are the head of the queue
+                while(true) {
+
+                      _u64 tmp = *fastprlock;
+                      if ( lockbit > tmp ) {
+                              if ( CAS(fastprlock, tmp, tmp | lockbit) ) {
+                                      release_queue(q);
+                                      return true;
+                              }
+                      }
+
+                      if ( *ptr != val ) {
+                              release_queue(q);
+                              return false;
+                      }
+                }
+   
+                //should never reach here
+                return true;
+        }
+
         //must play nicely with trylock_*
         bool trylock_pr(volatile T *ptr, T val) //__attribute__ ((noinline))
         {
@@ -269,21 +466,138 @@ public:
                 return true;
         }
 
+        //make the group's flag in fastprlock agree with whether anyone waits in
+        //the group. joiners and leavers both call this after changing grp, and
+        //whoever changes the flag looks at grp again afterwards, so a joiner
+        //racing the last one out can neither lose the flag nor leave it stale
+        inline void sync_pr_group(volatile _u64* grp, _u64 gmask)
+        {
+                while(1) {
+                        if ( 0 != *grp ) {
+                                if ( 0 != (*fastprlock & gmask) )
+                                        return;
+                                FAOR(fastprlock, gmask);
+                        } else {
+                                if ( 0 == (*fastprlock & gmask) )
+                                        return;
+                                FAAND(fastprlock, ~gmask);
+                        }
+                }
+        }
+
+        inline void clear_pr_group(volatile _u64* grp, _u64 ormask, _u64 gmask)
+        {
+                FAAND(grp, ~ormask);
+                sync_pr_group(grp, gmask);
+        }
+
+        //trylock_pr for more than 63 threads. priority p waits in bit p%64 of
+        //group p/64, and the group is flagged in fastprlock. we go when no higher
+        //group is flagged and nobody higher is waiting in our own group
+        bool trylock_pr_grouped(volatile T *ptr, T val) //__attribute__ ((noinline))
+        {
+	        _u64 mypri = get_perm_val(learner, lock_sched_id, id);
+                _u64 lockbit = (U64(1) << 63);
+                volatile _u64* grp = &prgroups[(mypri >> 6) * SmartLockLiteState::PRGROUP_STRIDE];
+                _u64 gmask = (U64(1) << (mypri >> 6));
+                _u64 gmmoogm = gmask | (gmask-1);
+                _u64 ormask = (U64(1) << (mypri & 63));
+                _u64 ormmooorm = ormask | (ormask-1);
+                bool needclear = false;
+
+                while(1) {
+
+                        if ( (gmmoogm >= *fastprlock) && (ormmooorm >= *grp) ) {
+
+                                _u64 thelock = FAOR(fastprlock, lockbit);
+                                if ( lockbit > thelock ) {
+                                        if ( needclear && (*grp & ormask) )
+                                                clear_pr_group(grp, ormask, gmask);
+                                        return true;
+                                } else {
+                                        //register in the group, then make sure the group is
+                                        //flagged. thelock is stale by now: the last one out may
+                                        //have taken the flag down since
+                                        if ( !(*grp & ormask) )
+                                                needclear = !(FAOR(grp, ormask) & ormask);
+                                        sync_pr_group(grp, gmask);
+                                }
+                        }
+
+                        if ( *ptr != val ) {
+                                if ( needclear )
+                                        clear_pr_group(grp, ormask, gmask);
+                                return false;
+                        }
+
+                        _u64 tmp;
+                        if ( (tmp=get_perm_val(learner, lock_sched_id, id)) != mypri ) {
+                                if ( needclear ) {
+                                        clear_pr_group(grp, ormask, gmask);
+                                        needclear = false;
+                                }
+                                mypri = tmp;
+                                grp = &prgroups[(mypri >> 6) * SmartLockLiteState::PRGROUP_STRIDE];
+                                gmask = (U64(1) << (mypri >> 6));
+                                gmmoogm = gmask | (gmask-1);
+                                ormask = (U64(1) << (mypri & 63));
+                                ormmooorm = ormask | (ormask-1);
+                        }
+                }
+   
+                //should never reach here
+                return true;
+        }
+
         bool trylock(volatile T *ptr, T val) //__attribute__ ((noinline))
         {
                 unsigned int thealg = alg;
                 switch(thealg) {
-                case PRLOCK: return trylock_pr(ptr,val);
+                case PRLOCK: return (NULL == prgroups) ? trylock_pr(ptr,val) : trylock_pr_grouped(ptr,val);
+                case QUEUE: return trylock_queue(ptr,val);
                 default: return trylock_ttas(ptr,val);
                 }
         }
 
+        void setalg(algorithm_t a)
+        {
+                if ( alg != a )
+                        alg = a;
+        }
+
         void unlock() //__attribute__ ((noinline))
         {
+#ifdef LOCKSTATS
+                holdhist[lockstats_bucket(CCP::System::read_cpu_ticks() - acquiredat)]++;
+#endif
 	        _u64 lockbit = (U64(1) << 63);
                 FAAND(fastprlock, ~lockbit);
         }
 
+        //the priority we currently wait with
+        int getpri()
+        {
+                return get_perm_val(learner, lock_sched_id, id);
+        }
+
+#ifdef LOCKSTATS
+        _u64 getwaithist(int bucket) { return waithist[bucket]; }
+        _u64 getholdhist(int bucket) { return holdhist[bucket]; }
+        _u64 getacquires()           { return acquires; }
+        _u64 getaborts()             { return aborts; }
+
+        void resetlockstats()
+        {
+                for(int b = 0; b < NUM_LOCKSTATS_BUCKETS; b++) {
+                        waithist[b] = 0;
+                        holdhist[b] = 0;
+                }
+                acquires = 0;
+                aborts = 0;
+                acquiredat = 0;
+        }
+#endif
+
 #ifdef CASSTATS
         unsigned int getcasops()
         {
@@ -315,6 +629,11 @@ private:
         SmartLockLiteNode<T>*                  slnodes; 
         unsigned int                           nthreads;
         LearningEngine*                        learner;
+        int                                    alg_tune_id;  //-1 unless the learner picks the algorithm
+        unsigned int                           unlocks;      //only touched by the holder
+#ifdef LOCKSTATS
+        _u64*                                  prioacquires; //acquisitions by priority; only the holder writes
+#endif
 
         char pad[CACHE_LINE_SIZE];
 
@@ -323,11 +642,24 @@ private:
 	        return (null != learner) ? learner->getmode() : LearningEngine::disabled;
 	}
 
+        //disc vals range 0..12, which doesn't divide by the three algorithms:
+        //PRLOCK gets 0..4 (the one left over), TTAS 5..8 and QUEUE 9..12
+        inline typename SmartLockLiteNode<T>::algorithm_t to_algorithm(int discval)
+        {
+                if ( discval < 0 )
+                        discval = 0;
+                if ( discval > 12 )
+                        discval = 12;
+                return (typename SmartLockLiteNode<T>::algorithm_t) ((discval * SmartLockLiteNode<T>::NUM_ALGORITHMS) / 13);
+        }
+
 public:
 
-        SmartLockLite(unsigned int threads, LearningEngine *le): nthreads(threads), learner(le), mode(get_mode(le))
+        SmartLockLite(unsigned int threads, LearningEngine *le): nthreads(threads), learner(le), mode(get_mode(le)), alg_tune_id(-1), unlocks(0)
         {
-                assert( threads <= 63 );
+                assert( threads <= SmartLockLiteState::MAX_THREADS );
+                if ( threads > 63 )
+                        state.init_groups(threads);
 
 #if 0
                 slnodes = (SmartLockLiteNode<T>*) CCP::Memory::byte_aligned_malloc(sizeof(SmartLockLiteNode<T>)*threads, CACHE_LINE_SIZE);
@@ -344,9 +676,21 @@ public:
                 if ( mode & LearningEngine::lock_scheduling )
                         lsid = le->register_lock_sched_id();
 
+                if ( mode & LearningEngine::lock_alg_tuning ) {
+                        alg_tune_id = le->register_sc_tune_id();
+                        a = to_algorithm(le->getdiscval(alg_tune_id, 0));
+                }
+
                 for(int i = 0; i < threads; i++) {
 		        slnodes[i] = SmartLockLiteNode<T>(&state, a, le, lsid, i);
                 }
+
+#ifdef LOCKSTATS
+                //learned priorities are a permutation of 0..threads-1
+                prioacquires = new _u64[threads];
+                for(int i = 0; i < threads; i++)
+                        prioacquires[i] = 0;
+#endif
                 CCP::Memory::read_write_barrier();
         }
 
@@ -356,26 +700,61 @@ public:
 	        CCP::Memory::byte_aligned_free(slnodes);
 #else
                 delete[] slnodes;
+#endif
+#ifdef LOCKSTATS
+                delete[] prioacquires;
 #endif
                 CCP::Memory::read_write_barrier();
         }
 
         bool lock(volatile T *ptr, T val, unsigned int id)
         {
+                if ( alg_tune_id >= 0 )
+                        slnodes[id].setalg(to_algorithm(learner->getdiscval(alg_tune_id, id)));
+#ifdef LOCKSTATS
+                if ( !slnodes[id].lock(ptr, val) )
+                        return false;
+                unsigned int pri = slnodes[id].getpri();
+                prioacquires[(pri < nthreads) ? pri : nthreads-1]++;
+                return true;
+#else
                 return slnodes[id].lock(ptr, val);
+#endif
         }
 
         void lock(unsigned int id)
         {
                 volatile T val = 0;
-                slnodes[id].lock(&val, val);
+                lock(&val, val, id);
         }
 
         void unlock(unsigned int id)
         {
+                //sampling touches shared learner state; the holder is alone here
+                if ( (alg_tune_id >= 0) && (0 == (++unlocks & 0xff)) )
+                        learner->samplediscval(alg_tune_id);
                 slnodes[id].unlock();
         }
 
+        //application priority hints for PRLOCK scheduling, e.g. to keep request
+        //threads ahead of background threads. they live in the learner (see
+        //LearningEngine::pinpriority); without a learner there is no scheduling
+        void pinpriority(unsigned int id, int pri)
+        {
+                if ( null != learner )
+                        learner->pinpriority(id, pri);
+        }
+        void biaspriority(unsigned int id, int bias)
+        {
+                if ( null != learner )
+                        learner->biaspriority(id, bias);
+        }
+        void clearpriorityhint(unsigned int id)
+        {
+                if ( null != learner )
+                        learner->clearpriorityhint(id);
+        }
+
 #ifdef CASSTATS
         unsigned int getcasops()
         {
@@ -397,6 +776,64 @@ public:
         }
 
 #endif
+
+#ifdef LOCKSTATS
+        //readable at any time; counts from other threads may be a little stale.
+        //bucket b covers [2^b, 2^(b+1)) cpu ticks
+        int getnumlockstatsbuckets()
+        {
+                return SmartLockLiteNode<T>::NUM_LOCKSTATS_BUCKETS;
+        }
+        _u64 getwaithist(unsigned int id, int bucket)
+        {
+                return slnodes[id].getwaithist(bucket);
+        }
+        _u64 getholdhist(unsigned int id, int bucket)
+        {
+                return slnodes[id].getholdhist(bucket);
+        }
+        _u64 getacquires(unsigned int id)
+        {
+                return slnodes[id].getacquires();
+        }
+        //lock() calls that gave up because the request was answered meanwhile
+        _u64 getaborts(unsigned int id)
+        {
+                return slnodes[id].getaborts();
+        }
+        //acquisitions made while holding priority pri (higher wins under PRLOCK)
+        _u64 getprioacquires(unsigned int pri)
+        {
+                return prioacquires[pri];
+        }
+
+        //only while nobody uses the lock
+        void resetlockstats()
+        {
+                for(int id = 0; id < nthreads; ++id)
+                        slnodes[id].resetlockstats();
+                for(int pri = 0; pri < nthreads; ++pri)
+                        prioacquires[pri] = 0;
+        }
+
+        void printlockstats(FILE* out)
+        {
+                int nb = SmartLockLiteNode<T>::NUM_LOCKSTATS_BUCKETS;
+                fprintf(out, "thread acquires aborts | wait log2(ticks) histogram | hold log2(ticks) histogram\n");
+                for(int id = 0; id < nthreads; ++id) {
+                        fprintf(out, "%d %llu %llu |", id, (unsigned long long) getacquires(id), (unsigned long long) getaborts(id));
+                        for(int b = 0; b < nb; ++b)
+                                fprintf(out, " %llu", (unsigned long long) getwaithist(id, b));
+                        fprintf(out, " |");
+                        for(int b = 0; b < nb; ++b)
+                                fprintf(out, " %llu", (unsigned long long) getholdhist(id, b));
+                        fprintf(out, "\n");
+                }
+                fprintf(out, "priority acquires\n");
+                for(int pri = nthreads-1; pri >= 0; --pri)
+                        fprintf(out, "%d %llu\n", pri, (unsigned long long) getprioacquires(pri));
+        }
+#endif
 };
 
 #endif
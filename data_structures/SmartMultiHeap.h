@@ -0,0 +1,193 @@
+#ifndef __SMART_MULTI_HEAP__
+#define __SMART_MULTI_HEAP__
+
+////////////////////////////////////////////////////////////////////////////////
+// File    : SmartMultiHeap.h
+// Author  : agent   email: agent@local
+// Written : 19 October 2026
+//
+// Relaxed priority queue in the style of the MultiQueue: several flat
+// combining pairing heap shards, random insertion, two-choice deleteMin.
+// The number of active shards (the degree of relaxation) is a discrete
+// knob tuned by the LearningEngine.
+//
+// Copyright (C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+////////////////////////////////////////////////////////////////////////////////
+// TODO:
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "FCBase.h"
+#include "SmartPairingHeap.h"
+#include "LearningEngine.h"
+#include "Monitor.h"
+
+using namespace CCP;
+
+template <class T, bool _AUTO_TUNE = true, bool _AUTO_REWARD = true>
+class SmartMultiHeap : public FCBase<T> {
+private:
+
+        //constants -----------------------------------
+        static final int          _SHARDS_PER_THREAD = 2;
+        static final int          _MAX_RELAXATION    = 12;   //disc vals range 0..12
+
+        //inner classes -------------------------------
+        typedef SmartPairHeap<T,false,_AUTO_REWARD> Shard;
+
+        struct ThreadInfo {
+                _u64 volatile     _seed    ATTRIBUTE_CACHE_ALIGNED;
+                int               _ops;
+                int               _cursor;   //next deactivated shard to look at
+                char              _pad     ATTRIBUTE_CACHE_ALIGNED;
+        };
+
+        //fields --------------------------------------
+        final int                 _NUM_SHARDS      ATTRIBUTE_CACHE_ALIGNED;
+        Shard**                   _shards;
+        ThreadInfo*               _thread_info;
+        Monitor*                  _mon;
+        LearningEngine*           _learner;
+        int                       _sc_tune_id;
+        char                      _pad             ATTRIBUTE_CACHE_ALIGNED;
+
+        //helper function -----------------------------
+
+        //number of shards currently in use; 1 is strict, _NUM_SHARDS is most relaxed
+        inline_ int active_shards(final int iThread) {
+                if ( !_AUTO_TUNE )
+                        return _NUM_SHARDS;
+
+                int relax;
+                _learner->tunedvals(iThread, ++_thread_info[iThread]._ops, 1, &_sc_tune_id, &relax, _MAX_RELAXATION);
+                return 1 + (relax * (_NUM_SHARDS-1) + _MAX_RELAXATION/2) / _MAX_RELAXATION;
+        }
+
+public:
+        static final boolean      _REWARDS_FROM_ANY_THREAD = true;
+
+        //public operations ---------------------------
+        SmartMultiHeap(Monitor* mon, LearningEngine* learner, final int num_shards = 0)
+        :       _NUM_SHARDS( (num_shards > 0) ? num_shards : _SHARDS_PER_THREAD*FCBase<T>::_NUM_THREADS ),
+                _mon(mon),
+                _learner(learner)
+        {
+                _shards = new Shard*[_NUM_SHARDS];
+                for (int i=0; i<_NUM_SHARDS; ++i)
+                        _shards[i] = new Shard(_mon, null);
+
+                _thread_info = (ThreadInfo*) Memory::byte_aligned_malloc(FCBase<T>::_NUM_THREADS*sizeof(ThreadInfo), CACHE_LINE_SIZE);
+                for (int i=0; i<FCBase<T>::_NUM_THREADS; ++i) {
+                        _thread_info[i]._seed = Random::getRandom((_u64) (i+1));
+                        _thread_info[i]._ops = 0;
+                        _thread_info[i]._cursor = 0;
+                }
+
+                _sc_tune_id = 0;
+                if ( _AUTO_TUNE )
+                        _sc_tune_id = _learner->register_sc_tune_id();
+
+                Memory::read_write_barrier();
+        }
+
+        virtual ~SmartMultiHeap()
+        {
+                for (int i=0; i<_NUM_SHARDS; ++i)
+                        delete _shards[i];
+                delete[] _shards;
+                Memory::byte_aligned_free(_thread_info);
+        }
+
+        //enq ......................................................
+        boolean add(final int iThread, PtrNode<T>* final inPtr) {
+                final int active = active_shards(iThread);
+                final int iShard = Random::getRandom(_thread_info[iThread]._seed, active);
+                return _shards[iShard]->add(iThread, inPtr);
+        }
+
+        //deq ......................................................
+        PtrNode<T>* remove(final int iThread, PtrNode<T>* final inPtr) {
+                final int active = active_shards(iThread);
+                ThreadInfo& info = _thread_info[iThread];
+                _u64 volatile& seed = info._seed;
+
+                //two-choice: take the smaller published minimum of two random shards
+                for (int iTry=0; iTry<active; ++iTry) {
+                        int i = Random::getRandom(seed, active);
+                        final int j = Random::getRandom(seed, active);
+                        if ( _shards[j]->peek_min_key() < _shards[i]->peek_min_key() )
+                                i = j;
+
+                        //shards deactivated when the relaxation shrank may still hold
+                        //elements. each try also looks at one of them, round robin, so
+                        //a small key left there is taken within _NUM_SHARDS tries
+                        if ( active < _NUM_SHARDS ) {
+                                if ( (info._cursor < active) || (info._cursor >= _NUM_SHARDS) )
+                                        info._cursor = active;
+                                final int k = info._cursor++;
+                                if ( _shards[k]->peek_min_key() < _shards[i]->peek_min_key() )
+                                        i = k;
+                        }
+
+                        if ( FCBase<T>::_MAX_INT == _shards[i]->peek_min_key() )
+                                continue;
+
+                        PtrNode<T>* final rv = _shards[i]->remove(iThread, inPtr);
+                        if ( FCBase<T>::_NULL_VALUE != (FCIntPtr) rv )
+                                return rv;
+                }
+
+                //everything sampled looked empty. sweep all shards, including the
+                //deactivated ones. the combiner publishes a shard's minimum before
+                //it answers an add, so a shard that reads _MAX_INT holds nothing
+                //that was added before this remove began
+                for (int i=0; i<_NUM_SHARDS; ++i) {
+                        if ( FCBase<T>::_MAX_INT == _shards[i]->peek_min_key() )
+                                continue;
+
+                        PtrNode<T>* final rv = _shards[i]->remove(iThread, inPtr);
+                        if ( FCBase<T>::_NULL_VALUE != (FCIntPtr) rv )
+                                return rv;
+                }
+
+                return (PtrNode<T>*) FCBase<T>::_NULL_VALUE;
+        }
+
+        //peek .....................................................
+        PtrNode<T>* contain(final int iThread, PtrNode<T>* final inPtr) {
+                final FCIntPtr inValue = (FCIntPtr) inPtr;
+                return (PtrNode<T>*) FCBase<T>::_NULL_VALUE;
+        }
+
+        //general .....................................................
+        int size() {
+                return 0;
+        }
+
+        final char* name() {
+                return _AUTO_TUNE ? "SmartMultiHeap" : "MultiHeap";
+        }
+
+        void cas_reset(final int iThread) {
+                for (int i=0; i<_NUM_SHARDS; ++i)
+                        _shards[i]->cas_reset(iThread);
+                FCBase<T>::_cas_info_ary[iThread].reset();
+        }
+
+};
+
+#endif
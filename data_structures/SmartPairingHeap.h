@@ -27,6 +27,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "PairingHeap.h"
+#include "DaryHeap.h"
 #include "FCBase.h"
 #include "LearningEngine.h"
 #include "SmartLockLite.h"
@@ -38,7 +39,10 @@
 
 using namespace CCP;
 
-template <class T, bool _AUTO_TUNE = true, bool _AUTO_REWARD = true>
+//_HEAP is the sequential heap the combiner applies requests to. it needs
+//insert, deleteMin, isEmpty, minKey and the static name_fc / name_smart.
+//PairHeap<T> and DaryHeap<T,D> both qualify.
+template <class T, bool _AUTO_TUNE = true, bool _AUTO_REWARD = true, class _HEAP = PairHeap<T> >
 class SmartPairHeap : public FCBase<T> {
 private:
 
@@ -58,11 +62,13 @@ private:
         final int                 _NUM_REP;
         final int                 _REP_THRESHOLD;
         char                      _pad2[CACHE_LINE_SIZE];
-        PairHeap<T>               _heap;
+        _HEAP                     _heap;
         char                      _pad3[CACHE_LINE_SIZE];
         Monitor*                  _mon;
         LearningEngine*           _learner;
         int                       _sc_tune_id;
+        char                      _pad4[CACHE_LINE_SIZE];
+        FCIntPtr volatile         _min_key;
 
         //helper function -----------------------------
         inline_ void flat_combining(final int iThread) {
@@ -91,6 +97,10 @@ private:
                                         if ( 0 == _gIsDedicatedMode )
                                                 ++num_changes;
                                         _heap.insert((PtrNode<T>*) curr_value);
+                                        //publish the minimum before answering: once add
+                                        //returns, peek_min_key must not read _MAX_INT
+                                        _min_key = _heap.minKey();
+                                        Memory::write_barrier();
                                         curr_slot->_req_ans = FCBase<T>::_NULL_VALUE;
                                         curr_slot->_time_stamp = FCBase<T>::_NULL_VALUE;
                                 } else if(FCBase<T>::_DEQ_VALUE == curr_value) {
@@ -111,9 +121,15 @@ private:
 
                 }//for repetition
 
+                //publish the current minimum so relaxed wrappers can peek without the lock
+                _min_key = _heap.isEmpty() ? FCBase<T>::_MAX_INT : _heap.minKey();
+
                 if ( _AUTO_REWARD )
                         _mon->addreward(iThread, total_changes);
 
+                if ( _AUTO_TUNE && (0 == (FCBase<T>::_cleanup_counter & 0xf)) )
+                        _learner->reportstate(LearningEngine::feat_batch_size, total_changes);
+
         }       
         
 public:
@@ -124,6 +140,7 @@ public:
                 _mon(mon),
                 _learner(learner)
         {
+                _min_key = FCBase<T>::_MAX_INT;
                 _sc_tune_id = 0;
                 if ( _AUTO_TUNE )
                         _sc_tune_id = _learner->register_sc_tune_id();
@@ -319,13 +336,18 @@ public:
                 return FCBase<T>::_NULL_VALUE;
         }
 
+        //key of the minimum as of the last combining pass; _MAX_INT if empty
+        FCIntPtr peek_min_key() {
+                return _min_key;
+        }
+
         //general .....................................................
         int size() {
                 return 0;
         }
 
         final char* name() {
-                return _AUTO_TUNE ? "SmartPairHeap" : "FCPairHeap";
+                return _AUTO_TUNE ? _HEAP::name_smart() : _HEAP::name_fc();
         }
 
         void cas_reset(final int iThread) {
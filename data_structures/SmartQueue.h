@@ -75,7 +75,11 @@ private:
         int volatile              _NODE_SIZE;
         Node* volatile            _new_node;
         int volatile              _size;
-        _u64 volatile             _dead_count;
+        //threads whose last combining pass did nothing, each counted once.
+        //a thread is counted when its mark equals the current dead epoch
+        int volatile              _dead_count;
+        int*                      _dead_mark;
+        int                       _dead_epoch;
         bool volatile             _empty           ATTRIBUTE_CACHE_ALIGNED;
         char                      _pad             ATTRIBUTE_CACHE_ALIGNED;
 
@@ -114,6 +118,7 @@ private:
                 int num_added = 0;
                 int num_removed = 0;
                 int total_changes = 0;
+                int num_requests = 0;
 
                 for (int iTry=0;iTry<maxPasses; ++iTry) {
 		        //test
@@ -124,6 +129,8 @@ private:
                         SlotInfo* curr_slot = FCBase<T>::_tail_slot.get();
                         while(null != curr_slot->_next) {
                                 final FCIntPtr curr_value = curr_slot->_req_ans;
+                                if ( (0 == iTry) && ((curr_value > FCBase<T>::_NULL_VALUE) || (FCBase<T>::_DEQ_VALUE == curr_value)) )
+                                        ++num_requests;
                                 if(curr_value > FCBase<T>::_NULL_VALUE) {
                                         if ( 0 == _gIsDedicatedMode )
                                                 ++num_changes; 
@@ -187,14 +194,26 @@ private:
 		                 _empty = false;
 		}
                                 
-                if ( (num_added==0) && (num_removed==0) )
-		        _dead_count |= (U64(1) << iThread);
-                else
-		        _dead_count = 0;
+                if ( (num_added==0) && (num_removed==0) ) {
+                        if ( _dead_mark[iThread] != _dead_epoch ) {
+                                _dead_mark[iThread] = _dead_epoch;
+                                ++_dead_count;
+                        }
+                } else if ( 0 != _dead_count ) {
+                        ++_dead_epoch;
+                        _dead_count = 0;
+                }
 
                 if ( _AUTO_REWARD )
                         _mon->addreward(iThread, total_changes);
 
+                //load as the learner sees it: who was waiting, how much we did
+                if ( _AUTO_TUNE && (0 == (FCBase<T>::_cleanup_counter & 0xf)) ) {
+                        _learner->reportstate(LearningEngine::feat_active_threads, num_requests);
+                        _learner->reportstate(LearningEngine::feat_batch_size, num_added + num_removed);
+                        _learner->reportstate(LearningEngine::feat_queue_length, _size);
+                }
+
                 if(0 == *deq_value_ary && null != _tail->_next) {
                         Node* tmp = _tail;
                         _tail = _tail->_next;
@@ -220,10 +239,13 @@ public:
                 _mon(mon),
                 _learner(learner)
         {
-	        assert( FCBase<T>::_NUM_THREADS <= (sizeof(_u64)*8) );
 	        _size = 0;
                 _empty = false;
                 _dead_count = 0;
+                _dead_epoch = 0;
+                _dead_mark = new int[FCBase<T>::_NUM_THREADS];
+                for (int i=0; i<FCBase<T>::_NUM_THREADS; ++i)
+                        _dead_mark[i] = -1;
                 _head = Node::get_new(FCBase<T>::_NUM_THREADS);
                 _tail = _head;
                 _head->_values[0] = 1;
@@ -249,6 +271,7 @@ public:
 #ifdef _USE_SMARTLOCK
                 delete _fc_lock;
 #endif
+                delete[] _dead_mark;
         }
 
 #ifdef _USE_SMARTLOCK
@@ -454,7 +477,7 @@ public:
         }
 
         bool dead() {
-	        return _dead_count == ((U64(-1) >> (sizeof(_u64)*8 - FCBase<T>::_NUM_THREADS)));
+	        return _dead_count == FCBase<T>::_NUM_THREADS;
         }
 
         bool empty() {
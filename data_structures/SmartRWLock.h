@@ -0,0 +1,198 @@
+
+#ifndef __SMARTRWLOCK__
+#define __SMARTRWLOCK__
+
+////////////////////////////////////////////////////////////////////////////////
+// File    : SmartRWLock.h
+// Author  : agent   email: agent@local
+// Written : 19 October 2026
+//
+// Reader-writer lock on top of SmartLockLite. Readers announce themselves
+// in a per-thread indicator (one cache line each) so read_lock/read_unlock
+// never write a shared line; a writer serializes with other writers through
+// a SmartLockLite (so writer scheduling is learned like any SmartLockLite)
+// and then raises _writer and waits for the indicators to drain.
+//
+// The reader/writer policy is a discrete knob: it is how long a writer that
+// holds the writer lock lets readers keep coming before it raises _writer
+// and shuts them out. 0 is strict writer preference; larger values favour
+// readers. It is tuned by the LearningEngine when the learner does
+// scancount_tuning, which means the learner needs room for one more knob.
+// Like SmartLockLite, the lock itself adds no reward; the application
+// reports its throughput through the learner's Monitor.
+//
+// Copyright (C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+////////////////////////////////////////////////////////////////////////////////
+
+#include <assert.h>
+#include "LearningEngine.h"
+#include "SmartLockLite.h"
+#include "cpp_framework.h"
+#include "portable_defns.h"
+
+
+using namespace std;
+
+
+template <typename T = int>
+class SmartRWLock
+{
+private:
+
+        static const unsigned int SPIN_YIELD      = 0x3ff;   //yield every 1024 spins
+        static const int          MAX_POLICY      = 12;      //disc vals range 0..12
+        static const int          DEFAULT_POLICY  = 0;
+
+        struct ReaderIndicator {
+                volatile unsigned int  active  ATTRIBUTE_CACHE_ALIGNED;
+                char                   pad     ATTRIBUTE_CACHE_ALIGNED;
+        };
+
+        volatile unsigned int                  writer      ATTRIBUTE_CACHE_ALIGNED;
+        ReaderIndicator*                       readers;
+        SmartLockLite<T>*                      wlock;
+        unsigned int                           nthreads;
+        LearningEngine*                        learner;
+        int                                    policy_tune_id;  //-1 unless the learner tunes the policy
+        int                                    policy;          //only touched by the writer
+        unsigned int                           unlocks;         //only touched by the writer
+
+        char pad[CACHE_LINE_SIZE];
+
+        inline bool readers_present()
+        {
+                for(unsigned int i = 0; i < nthreads; i++) {
+                        if ( 0 != readers[i].active )
+                                return true;
+                }
+                return false;
+        }
+
+        //writer's patience with incoming readers, in reader scans
+        inline unsigned int patience()
+        {
+                return (0 == policy) ? 0 : (16u << policy);
+        }
+
+public:
+
+        SmartRWLock(unsigned int threads, LearningEngine *le): nthreads(threads), learner(le), policy_tune_id(-1), policy(DEFAULT_POLICY), unlocks(0)
+        {
+                writer = 0;
+                readers = new ReaderIndicator[threads];
+                for(unsigned int i = 0; i < threads; i++)
+                        readers[i].active = 0;
+
+                wlock = new SmartLockLite<T>(threads, le);
+
+                if ( (null != le) && (le->getmode() & LearningEngine::scancount_tuning) )
+                        policy_tune_id = le->register_sc_tune_id();
+
+                CCP::Memory::read_write_barrier();
+        }
+
+        ~SmartRWLock()
+        {
+                delete wlock;
+                delete[] readers;
+                CCP::Memory::read_write_barrier();
+        }
+
+        void read_lock(unsigned int id)
+        {
+                volatile unsigned int& active = readers[id].active;
+                while(true) {
+                        active = 1;
+                        //a writer raises _writer and then scans; we publish and then look
+                        CCP::Memory::read_write_barrier();
+                        if ( 0 == writer )
+                                return;
+
+                        active = 0;
+                        unsigned int spins = 0;
+                        while( 0 != writer ) {
+                                if ( 0 == (++spins & SPIN_YIELD) )
+                                        CCP::Thread::yield();
+                        }
+                }
+        }
+
+        void read_unlock(unsigned int id)
+        {
+                CCP::Memory::read_write_barrier();
+                readers[id].active = 0;
+        }
+
+        void write_lock(unsigned int id)
+        {
+                wlock->lock(id);
+
+                if ( policy_tune_id >= 0 ) {
+                        policy = learner->getdiscval(policy_tune_id, id);
+                        if ( policy < 0 )
+                                policy = 0;
+                        if ( policy > MAX_POLICY )
+                                policy = MAX_POLICY;
+                }
+
+                //let readers in for a while hoping they drain by themselves
+                final unsigned int wait = patience();
+                for(unsigned int i = 0; (i < wait) && readers_present(); i++);
+
+                writer = 1;
+                CCP::Memory::read_write_barrier();
+
+                unsigned int spins = 0;
+                while( readers_present() ) {
+                        if ( 0 == (++spins & SPIN_YIELD) )
+                                CCP::Thread::yield();
+                }
+        }
+
+        void write_unlock(unsigned int id)
+        {
+                //sampling touches shared learner state; the writer is alone here
+                if ( (policy_tune_id >= 0) && (0 == (++unlocks & 0xff)) )
+                        learner->samplediscval(policy_tune_id);
+
+                CCP::Memory::read_write_barrier();
+                writer = 0;
+                wlock->unlock(id);
+        }
+
+        int getpolicy()
+        {
+                return policy;
+        }
+
+#ifdef CASSTATS
+        unsigned int getcasops()
+        {
+                return wlock->getcasops();
+        }
+        unsigned int getcasfails()
+        {
+                return wlock->getcasfails();
+        }
+        void resetcasops(unsigned int id)
+        {
+                wlock->resetcasops(id);
+        }
+#endif
+};
+
+#endif
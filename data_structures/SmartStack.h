@@ -0,0 +1,310 @@
+#ifndef __SMART_STACK__
+#define __SMART_STACK__
+
+////////////////////////////////////////////////////////////////////////////////
+// File    : SmartStack.h
+// Author  : agent   email: agent@local
+// Written : 19 October 2026
+//
+// Flat combining stack built like SmartQueue: published requests live on
+// the FCBase slot list, the combiner lock is a SmartLockLite, the scancount
+// is tuned by the LearningEngine and work done is reported to the Monitor.
+// In each combining pass the combiner first pairs pending pushes with
+// pending pops and hands the values over directly (elimination); only the
+// unmatched remainder touches _stack_ary.
+//
+// Copyright (C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+////////////////////////////////////////////////////////////////////////////////
+// TODO:
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "cpp_framework.h"
+#include "FCBase.h"
+#include "LearningEngine.h"
+#include "SmartLockLite.h"
+#include "Monitor.h"
+
+using namespace CCP;
+
+template <class T, bool _AUTO_TUNE = true, bool _AUTO_REWARD = true>
+class SmartStack : public FCBase<T> {
+private:
+
+        //constants -----------------------------------
+        static final int          _INITIAL_STACK_SIZE = 1024;
+
+        //fields --------------------------------------
+        SmartLockLite<FCIntPtr>*  _fc_lock         ATTRIBUTE_CACHE_ALIGNED;
+        Monitor*                  _mon;
+        LearningEngine*           _learner;
+        int                       _sc_tune_id;
+
+        //only touched by the combiner
+        FCIntPtr*                 _stack_ary       ATTRIBUTE_CACHE_ALIGNED;
+        int                       _stack_ary_size;
+        int volatile              _top_indx;
+        int volatile              _eliminated;
+        SlotInfo**                _push_slots;
+        SlotInfo**                _pop_slots;
+        char                      _pad             ATTRIBUTE_CACHE_ALIGNED;
+
+
+        //helper function -----------------------------
+        inline_ void push_stack(final FCIntPtr value) {
+                if ( _top_indx == _stack_ary_size ) {
+                        FCIntPtr* final new_ary = new FCIntPtr[2*_stack_ary_size];
+                        memcpy((void*) new_ary, (void*) _stack_ary, _stack_ary_size*sizeof(FCIntPtr));
+                        delete[] _stack_ary;
+                        _stack_ary = new_ary;
+                        _stack_ary_size *= 2;
+                }
+                _stack_ary[_top_indx] = value;
+                ++_top_indx;
+        }
+
+        inline_ void flat_combining(final int iThread) {
+
+                ++FCBase<T>::_cleanup_counter;
+                int maxPasses;
+                if ( !_AUTO_TUNE ) {
+                        maxPasses = FCBase<T>::_num_passes;
+                }
+                else {
+                        if ( 0 == (FCBase<T>::_cleanup_counter & 0xff) )
+                                maxPasses = 1 + 10*_learner->samplediscval(_sc_tune_id);
+                        else
+                                maxPasses = 1 + 10*_learner->getdiscval(_sc_tune_id, iThread);
+                }
+
+                int total_changes = 0;
+                int num_requests = 0;
+
+                for (int iTry=0; iTry<maxPasses; ++iTry) {
+
+                        int num_changes = 0;
+                        int num_push = 0;
+                        int num_pop = 0;
+
+                        //collect pending requests
+                        SlotInfo* curr_slot = FCBase<T>::_tail_slot.get();
+                        while(null != curr_slot->_next) {
+                                final FCIntPtr curr_value = curr_slot->_req_ans;
+                                if(curr_value > FCBase<T>::_NULL_VALUE)
+                                        _push_slots[num_push++] = curr_slot;
+                                else if(FCBase<T>::_DEQ_VALUE == curr_value)
+                                        _pop_slots[num_pop++] = curr_slot;
+                                curr_slot = curr_slot->_next;
+                        }
+                        if ( 0 == iTry )
+                                num_requests = num_push + num_pop;
+
+                        //eliminate push/pop pairs without touching the stack
+                        final int num_pairs = (num_push < num_pop) ? num_push : num_pop;
+                        for (int i=0; i<num_pairs; ++i) {
+                                SlotInfo* final push_slot = _push_slots[num_push-1-i];
+                                SlotInfo* final pop_slot = _pop_slots[i];
+                                pop_slot->_req_ans = -(push_slot->_req_ans);
+                                pop_slot->_time_stamp = FCBase<T>::_NULL_VALUE;
+                                push_slot->_req_ans = FCBase<T>::_NULL_VALUE;
+                                push_slot->_time_stamp = FCBase<T>::_NULL_VALUE;
+                                num_changes += ( 0 == _gIsDedicatedMode ) ? 2 : 1;
+                        }
+                        _eliminated += num_pairs;
+
+                        //leftover pushes
+                        for (int i=0; i<(num_push-num_pairs); ++i) {
+                                SlotInfo* final push_slot = _push_slots[i];
+                                push_stack(push_slot->_req_ans);
+                                push_slot->_req_ans = FCBase<T>::_NULL_VALUE;
+                                push_slot->_time_stamp = FCBase<T>::_NULL_VALUE;
+                                if ( 0 == _gIsDedicatedMode )
+                                        ++num_changes;
+                        }
+
+                        //leftover pops. an empty answer is only given on the last pass
+                        //since a later pass may still bring a push to eliminate against
+                        for (int i=num_pairs; i<num_pop; ++i) {
+                                SlotInfo* final pop_slot = _pop_slots[i];
+                                if ( _top_indx > 0 ) {
+                                        --_top_indx;
+                                        pop_slot->_req_ans = -(_stack_ary[_top_indx]);
+                                        pop_slot->_time_stamp = FCBase<T>::_NULL_VALUE;
+                                        ++num_changes;
+                                } else if ( iTry == maxPasses-1 ) {
+                                        pop_slot->_req_ans = FCBase<T>::_NULL_VALUE;
+                                        pop_slot->_time_stamp = FCBase<T>::_NULL_VALUE;
+                                        if ( 0 == _gIsDedicatedMode )
+                                                ++num_changes;
+                                }
+                        }
+
+                        total_changes += num_changes;
+
+                }//for repetition
+
+                if ( _AUTO_REWARD )
+                        _mon->addreward(iThread, total_changes);
+
+                if ( _AUTO_TUNE && (0 == (FCBase<T>::_cleanup_counter & 0xf)) ) {
+                        _learner->reportstate(LearningEngine::feat_active_threads, num_requests);
+                        _learner->reportstate(LearningEngine::feat_batch_size, total_changes);
+                        _learner->reportstate(LearningEngine::feat_queue_length, _top_indx);
+                }
+        }
+
+public:
+        //public operations ---------------------------
+        SmartStack(Monitor* mon, LearningEngine* learner)
+        :       _mon(mon),
+                _learner(learner)
+        {
+                _stack_ary_size = _INITIAL_STACK_SIZE;
+                _stack_ary = new FCIntPtr[_stack_ary_size];
+                _top_indx = 0;
+                _eliminated = 0;
+
+                _push_slots = new SlotInfo*[FCBase<T>::_MAX_THREADS];
+                _pop_slots = new SlotInfo*[FCBase<T>::_MAX_THREADS];
+
+                _sc_tune_id = 0;
+                if ( _AUTO_TUNE )
+                        _sc_tune_id = _learner->register_sc_tune_id();
+
+                _fc_lock = new SmartLockLite<FCIntPtr>(FCBase<T>::_NUM_THREADS, _learner);
+
+                Memory::read_write_barrier();
+        }
+
+        virtual ~SmartStack()
+        {
+                delete _fc_lock;
+                delete[] _stack_ary;
+                delete[] _push_slots;
+                delete[] _pop_slots;
+        }
+
+        //push .....................................................
+        boolean add(final int iThread, PtrNode<T>* final inPtr) {
+
+                final FCIntPtr inValue = (FCIntPtr) inPtr;
+
+                SlotInfo* my_slot = FCBase<T>::_tls_slot_info.get();
+                if(null == my_slot)
+                        my_slot = FCBase<T>::get_new_slot();
+
+                SlotInfo* volatile& my_next   = my_slot->_next;
+                FCIntPtr volatile*  my_re_ans = &my_slot->_req_ans;
+
+                Memory::read_write_barrier();
+                *my_re_ans = inValue;
+
+                //this is needed because the combiner may remove you
+                if (null == my_next)
+                        FCBase<T>::enq_slot(my_slot);
+
+                boolean is_cas = _fc_lock->lock(my_re_ans, inValue, iThread);
+                // when we get here, we either aborted or succeeded
+                // abort happens when we got our answer
+                if ( is_cas )
+                {
+                        // got the lock so we should do flat combining
+                        CasInfo& my_cas_info = FCBase<T>::_cas_info_ary[iThread];
+                        ++(my_cas_info._locks);
+                        flat_combining(iThread);
+                        _fc_lock->unlock(iThread);
+                }
+
+                return true;
+        }
+
+        //pop ......................................................
+        PtrNode<T>* remove(final int iThread, PtrNode<T>* final inPtr) {
+
+                final FCIntPtr inValue = (FCIntPtr) inPtr;
+
+                SlotInfo* my_slot = FCBase<T>::_tls_slot_info.get();
+                if(null == my_slot)
+                        my_slot = FCBase<T>::get_new_slot();
+
+                SlotInfo* volatile&     my_next = my_slot->_next;
+                FCIntPtr volatile* my_re_ans = &my_slot->_req_ans;
+                *my_re_ans = FCBase<T>::_DEQ_VALUE;
+
+                //this is needed because the combiner may remove you
+                if(null == my_next)
+                        FCBase<T>::enq_slot(my_slot);
+
+                boolean is_cas = _fc_lock->lock(my_re_ans, FCBase<T>::_DEQ_VALUE, iThread);
+                if( is_cas )
+                {
+                        CasInfo& my_cas_info = FCBase<T>::_cas_info_ary[iThread];
+                        ++(my_cas_info._locks);
+                        flat_combining(iThread);
+                        _fc_lock->unlock(iThread);
+                }
+
+                return (PtrNode<T>*) -(*my_re_ans);
+        }
+
+        //peek .....................................................
+        PtrNode<T>* contain(final int iThread, PtrNode<T>* final inPtr) {
+                final FCIntPtr inValue = (FCIntPtr) inPtr;
+                return (PtrNode<T>*) FCBase<T>::_NULL_VALUE;
+        }
+
+        //general .....................................................
+        int size() {
+                return _top_indx;
+        }
+
+        //push/pop pairs the combiner matched without touching _stack_ary
+        int eliminated() {
+                return _eliminated;
+        }
+
+        final char* name() {
+                return _AUTO_TUNE ? "SmartStack" : "FCElimStack";
+        }
+
+        void cas_reset(final int iThread) {
+                _fc_lock->resetcasops(iThread);
+                FCBase<T>::_cas_info_ary[iThread].reset();
+        }
+
+        void print_custom() {
+                int failed = 0;
+                int succ = 0;
+                int ops = 0;
+                int locks = 0;
+
+                for (int i=0; i<FCBase<T>::_NUM_THREADS; ++i) {
+                        failed += FCBase<T>::_cas_info_ary[i]._failed;
+                        succ += FCBase<T>::_cas_info_ary[i]._succ;
+                        ops += FCBase<T>::_cas_info_ary[i]._ops;
+                        locks += FCBase<T>::_cas_info_ary[i]._locks;
+                }
+                int tmp1 = _fc_lock->getcasops();
+                int tmp2 = _fc_lock->getcasfails();
+                succ += tmp1 - tmp2;
+                failed += tmp2;
+                printf(" 0 0 0 0 0 0 ( %d, %d, %d, %d, %d )", ops, locks, succ, failed, failed+succ);
+        }
+
+};
+
+#endif
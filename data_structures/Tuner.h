@@ -0,0 +1,656 @@
+#ifndef __TUNER__
+#define __TUNER__
+
+////////////////////////////////////////////////////////////////////////////////
+// File    : Tuner.h
+// Author  : agent   email: agent@local
+// Written : 19 October 2026
+//
+// The learning algorithms behind LearningEngine. A Tuner is handed the
+// actions to learn as an rl_engine action description (permutations and
+// discrete values, written to the entries' vals) and is told the reward
+// earned by the actions currently in effect.
+//
+// NacTuner is the natural actor-critic from rl_engine. BanditTuner is a
+// much cheaper alternative: each discrete action is a UCB1 bandit over its
+// values and each permutation is drawn from a Plackett-Luce model whose
+// per-item scores follow the reward. It does no matrix work, so an update
+// costs O(values + items) instead of a least squares solve.
+//
+// Each reward comes with state features (the first is a constant 1, the
+// rest scaled to [0, 1]). NacTuner uses them in its critic. BanditTuner
+// keeps separate statistics for each high/low pattern of the features, so
+// it learns one setting per load level and switches as soon as the load
+// moves instead of unlearning the previous one.
+//
+// save/load write and read a Tuner's learned parameters as text so that a
+// policy can be carried over to the next run (see LearningEngine::warmstart).
+// load only succeeds on a file saved by a Tuner of the same kind and shape.
+//
+// Copyright (C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+////////////////////////////////////////////////////////////////////////////////
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include "rl_agent_c.h"
+#include "cpp_framework.h"
+#include "portable_defns.h"
+
+
+//sorts items by descending key
+struct KeyOrder {
+        const double* key;
+        KeyOrder(const double* k): key(k) {}
+        bool operator()(int a, int b) const
+        {
+                return key[a] > key[b];
+        }
+};
+
+
+class Tuner
+{
+public:
+        virtual ~Tuner() {}
+
+        //credit the actions currently in effect with reward
+        virtual void update(double reward, double *statefeats) = 0;
+
+        //draw new values for every action / for action act
+        virtual void sample() = 0;
+        virtual void sample(int act) = 0;
+
+        //set every action to the value it currently believes best (no exploration)
+        virtual void greedy() = 0;
+
+        //whether sampling would almost always give the greedy values anyway
+        virtual bool converged() = 0;
+
+        //learned parameters, as text
+        virtual void save(FILE *f) = 0;
+        virtual bool load(FILE *f) = 0;
+
+protected:
+        //a Plackett-Luce order over log weights score is settled when each
+        //item outweighs the next by MARGIN (a swap then has odds under 5%).
+        //order is scratch space for n items
+        static bool settledorder(const double* score, int n, int* order)
+        {
+                final double MARGIN = 3;
+                for(int i = 0; i < n; i++)
+                        order[i] = i;
+                std::sort(order, order + n, KeyOrder(score));
+                for(int i = 0; i + 1 < n; i++) {
+                        if ( score[order[i]] - score[order[i+1]] < MARGIN )
+                                return false;
+                }
+                return true;
+        }
+};
+
+
+class NacTuner : public Tuner
+{
+private:
+        rl_nac_t        r;
+        int             num_acts;
+        rl_act_entry_t* acts;
+        double*         key;
+        int*            order;
+
+public:
+        NacTuner(int num_state_feats, rl_act_desc_t *rad, double slowdownratio): num_acts(rad->act_cnt)
+        {
+                r = rl_nac_init( num_state_feats, rad, slowdownratio );
+
+                //greedy needs the shapes and where to write
+                int maxn = 1;
+                acts = new rl_act_entry_t[num_acts];
+                for(int a = 0; a < num_acts; a++) {
+                        acts[a] = rad->acts[a];
+                        if ( (RLA_PERM == acts[a].type) && (acts[a].first_param > maxn) )
+                                maxn = acts[a].first_param;
+                }
+                key = new double[maxn];
+                order = new int[maxn];
+        }
+
+        ~NacTuner()
+        {
+                rl_nac_deinit( r );
+                delete[] acts;
+                delete[] key;
+                delete[] order;
+        }
+
+        void update(double reward, double *statefeats)
+        {
+                rl_nac_update( r, reward, statefeats );
+        }
+
+        void sample()
+        {
+                rl_nac_action_sample( r );
+        }
+
+        void sample(int act)
+        {
+                rl_nac_action_sample_individual( r, act );
+        }
+
+        //the params are log weights: a permutation lists items by descending
+        //weight, a discrete action takes the heaviest option
+        void greedy()
+        {
+                for(int a = 0; a < num_acts; a++) {
+                        int cnt;
+                        double* params;
+                        rl_nac_get_params( r, a, &cnt, &params );
+                        int* vals = (int*) acts[a].vals;
+
+                        if ( RLA_PERM == acts[a].type ) {
+                                for(int i = 0; i < cnt; i++) {
+                                        key[i] = params[i];
+                                        order[i] = i;
+                                }
+                                std::sort(order, order + cnt, KeyOrder(key));
+                                for(int i = 0; i < cnt; i++)
+                                        vals[i] = order[i];
+                        } else if ( RLA_DISCRETE == acts[a].type ) {
+                                int best = 0;
+                                for(int v = 1; v < cnt; v++) {
+                                        if ( params[v] > params[best] )
+                                                best = v;
+                                }
+                                for(int i = 0; i < acts[a].first_param; i++)
+                                        vals[i] = best;
+                        }
+                }
+        }
+
+        //every permutation is settled and every discrete action puts 95% of
+        //its probability on one option
+        bool converged()
+        {
+                for(int a = 0; a < num_acts; a++) {
+                        int cnt;
+                        double* params;
+                        rl_nac_get_params( r, a, &cnt, &params );
+
+                        if ( RLA_PERM == acts[a].type ) {
+                                if ( !settledorder(params, cnt, order) )
+                                        return false;
+                        } else if ( RLA_DISCRETE == acts[a].type ) {
+                                int best = 0;
+                                for(int v = 1; v < cnt; v++) {
+                                        if ( params[v] > params[best] )
+                                                best = v;
+                                }
+                                double rest = 0;
+                                for(int v = 0; v < cnt; v++) {
+                                        if ( v != best )
+                                                rest += exp(params[v] - params[best]);
+                                }
+                                if ( rest > 1. / .95 - 1. )
+                                        return false;
+                        }
+                }
+                return true;
+        }
+
+        //the policy parameters of each action
+        void save(FILE *f)
+        {
+                fprintf(f, "nac %d\n", num_acts);
+                for(int a = 0; a < num_acts; a++) {
+                        int cnt;
+                        double* params;
+                        rl_nac_get_params( r, a, &cnt, &params );
+                        fprintf(f, "%d", cnt);
+                        for(int i = 0; i < cnt; i++)
+                                fprintf(f, " %.17g", params[i]);
+                        fprintf(f, "\n");
+                }
+        }
+
+        bool load(FILE *f)
+        {
+                int nacts;
+                if ( (1 != fscanf(f, " nac %d", &nacts)) || (nacts != num_acts) )
+                        return false;
+                for(int a = 0; a < num_acts; a++) {
+                        int cnt, fcnt;
+                        double* params;
+                        rl_nac_get_params( r, a, &cnt, &params );
+                        if ( (1 != fscanf(f, "%d", &fcnt)) || (fcnt != cnt) )
+                                return false;
+                        for(int i = 0; i < cnt; i++) {
+                                if ( 1 != fscanf(f, "%lf", &params[i]) )
+                                        return false;
+                        }
+                }
+                return true;
+        }
+};
+
+
+class BanditTuner : public Tuner
+{
+private:
+
+        static final int    WINDOW       = 64;   //rewards averaged per arm before old ones fade
+        static final int    MAX_SCORE    = 20;   //keeps exp(score) finite
+        static final int    MAX_CTX_BITS = 4;    //state features that split contexts
+        static final int    SETTLED      = 32;   //greedy draws in a row for a converged arm
+
+        //one bandit per discrete value to pick; statistics are kept per context
+        struct Bandit {
+                int*    val;
+                int     nvals;
+                int     chosen;
+                int     ctx;          //context chosen was drawn in
+                int     streak;       //draws in a row that were also the greedy choice
+                int*    total;        //per context
+                int*    count;        //per context and value
+                double* mean;
+        };
+
+        //Plackett-Luce model of one permutation, one set of scores per context
+        struct Perm {
+                int*    vals;
+                int     n;
+                int     ctx;
+                double* score;
+                double* key;
+                int*    order;
+                int*    ranked;       //scratch for converged
+                double* sums;
+                double* grad;
+        };
+
+        Bandit*             bandits;
+        int                 num_bandits;
+        Perm*               perms;
+        int                 num_perms;
+        int*                first;        //per action: its first bandit or its perm
+        int*                width;        //per action: how many bandits it owns
+        bool*               isperm;
+        int                 num_acts;
+        int                 ctx_bits;
+        int                 num_ctx;
+        int                 ctx;          //context of the newest state
+        double*             baseline;     //per context: running mean reward
+        double*             spread;       //per context: running mean |reward - baseline|
+        int*                rewards;
+        struct drand48_data rng_state;
+
+        //each state feature past the first (the constant) is high (>= .5) or
+        //low; the pattern of highs picks the context
+        int context(double *statefeats)
+        {
+                int c = 0;
+                for(int i = 0; i < ctx_bits; i++) {
+                        if ( statefeats[1+i] >= .5 )
+                                c |= (1 << i);
+                }
+                return c;
+        }
+
+        void samplebandit(Bandit& b)
+        {
+                //untried values first, then the best upper confidence bound
+                b.ctx = ctx;
+                int* count = &b.count[ctx * b.nvals];
+                double* mean = &b.mean[ctx * b.nvals];
+                int best = -1;
+                int greedy = -1;
+                double bestucb = 0;
+                double lt = log((double) (b.total[ctx] + 1));
+                for(int v = 0; v < b.nvals; v++) {
+                        if ( 0 == count[v] ) {
+                                best = v;
+                                greedy = -1;
+                                break;
+                        }
+                        double ucb = mean[v] + spread[ctx] * sqrt(2 * lt / count[v]);
+                        if ( (best < 0) || (ucb > bestucb) ) {
+                                best = v;
+                                bestucb = ucb;
+                        }
+                        if ( (greedy < 0) || (mean[v] > mean[greedy]) )
+                                greedy = v;
+                }
+                b.streak = (best == greedy) ? b.streak + 1 : 0;
+                b.chosen = best;
+                *b.val = best;
+        }
+
+        void sampleperm(Perm& p)
+        {
+                //adding Gumbel noise to the scores and sorting draws from Plackett-Luce
+                p.ctx = ctx;
+                double* score = &p.score[ctx * p.n];
+                for(int i = 0; i < p.n; i++) {
+                        double u;
+                        drand48_r( &rng_state, &u );
+                        if ( u < 1e-300 )
+                                u = 1e-300;
+                        p.key[i] = score[i] - log(-log(u));
+                        p.order[i] = i;
+                }
+                std::sort(p.order, p.order + p.n, KeyOrder(p.key));
+                for(int i = 0; i < p.n; i++)
+                        p.vals[i] = p.order[i];
+        }
+
+        void updateperm(Perm& p, double adv)
+        {
+                //d log P(order) / d score_j = 1 - exp(score_j) * sum_{k <= pos(j)} 1/S_k
+                //where S_k is the total weight still unplaced at step k
+                double* score = &p.score[p.ctx * p.n];
+                double s = 0;
+                for(int k = p.n - 1; k >= 0; k--) {
+                        s += exp(score[p.order[k]]);
+                        p.sums[k] = s;
+                }
+                double inv = 0;
+                for(int k = 0; k < p.n; k++) {
+                        int j = p.order[k];
+                        inv += 1. / p.sums[k];
+                        p.grad[j] = 1. - exp(score[j]) * inv;
+                }
+                for(int j = 0; j < p.n; j++) {
+                        double sc = score[j] + 0.1 * adv * p.grad[j];
+                        score[j] = (sc > MAX_SCORE) ? MAX_SCORE : ((sc < -MAX_SCORE) ? -MAX_SCORE : sc);
+                }
+        }
+
+public:
+
+        //num_state_feats counts the constant feature; up to MAX_CTX_BITS of
+        //the others split the statistics into contexts
+        BanditTuner(rl_act_desc_t *rad, int num_state_feats = 1): ctx(0)
+        {
+                ctx_bits = num_state_feats - 1;
+                if ( ctx_bits > MAX_CTX_BITS )
+                        ctx_bits = MAX_CTX_BITS;
+                if ( ctx_bits < 0 )
+                        ctx_bits = 0;
+                num_ctx = 1 << ctx_bits;
+
+                baseline = new double[num_ctx];
+                spread = new double[num_ctx];
+                rewards = new int[num_ctx];
+                for(int c = 0; c < num_ctx; c++) {
+                        baseline[c] = 0;
+                        spread[c] = 0;
+                        rewards[c] = 0;
+                }
+
+                num_acts = rad->act_cnt;
+                first = new int[num_acts];
+                width = new int[num_acts];
+                isperm = new bool[num_acts];
+
+                num_bandits = 0;
+                num_perms = 0;
+                for(int a = 0; a < num_acts; a++) {
+                        rl_act_entry_t& e = rad->acts[a];
+                        assert( (RLA_PERM == e.type) || (RLA_DISCRETE == e.type) );
+                        isperm[a] = (RLA_PERM == e.type);
+                        first[a] = isperm[a] ? num_perms++ : num_bandits;
+                        width[a] = isperm[a] ? 1 : e.first_param;
+                        if ( !isperm[a] )
+                                num_bandits += e.first_param;
+                }
+
+                bandits = new Bandit[num_bandits];
+                perms = new Perm[num_perms];
+                for(int a = 0; a < num_acts; a++) {
+                        rl_act_entry_t& e = rad->acts[a];
+                        if ( isperm[a] ) {
+                                Perm& p = perms[first[a]];
+                                p.vals = (int*) e.vals;
+                                p.n = e.first_param;
+                                p.ctx = 0;
+                                p.score = new double[p.n * num_ctx];
+                                p.key = new double[p.n];
+                                p.order = new int[p.n];
+                                p.ranked = new int[p.n];
+                                p.sums = new double[p.n];
+                                p.grad = new double[p.n];
+                                for(int i = 0; i < p.n * num_ctx; i++)
+                                        p.score[i] = 0;
+                                for(int i = 0; i < p.n; i++)
+                                        p.order[i] = i;
+                        } else {
+                                for(int i = 0; i < e.first_param; i++) {
+                                        Bandit& b = bandits[first[a] + i];
+                                        b.val = ((int*) e.vals) + i;
+                                        b.nvals = e.second_param;
+                                        b.chosen = *b.val;
+                                        if ( (b.chosen < 0) || (b.chosen >= b.nvals) )
+                                                b.chosen = b.nvals - 1;
+                                        b.ctx = 0;
+                                        b.streak = 0;
+                                        b.total = new int[num_ctx];
+                                        b.count = new int[b.nvals * num_ctx];
+                                        b.mean = new double[b.nvals * num_ctx];
+                                        for(int c = 0; c < num_ctx; c++)
+                                                b.total[c] = 0;
+                                        for(int v = 0; v < b.nvals * num_ctx; v++) {
+                                                b.count[v] = 0;
+                                                b.mean[v] = 0;
+                                        }
+                                }
+                        }
+                }
+
+                srand48_r( 42, &rng_state );
+        }
+
+        ~BanditTuner()
+        {
+                for(int i = 0; i < num_bandits; i++) {
+                        delete[] bandits[i].total;
+                        delete[] bandits[i].count;
+                        delete[] bandits[i].mean;
+                }
+                for(int i = 0; i < num_perms; i++) {
+                        delete[] perms[i].score;
+                        delete[] perms[i].key;
+                        delete[] perms[i].order;
+                        delete[] perms[i].ranked;
+                        delete[] perms[i].sums;
+                        delete[] perms[i].grad;
+                }
+                delete[] bandits;
+                delete[] perms;
+                delete[] first;
+                delete[] width;
+                delete[] isperm;
+                delete[] baseline;
+                delete[] spread;
+                delete[] rewards;
+        }
+
+        //reward was earned in the current context; statefeats is the state
+        //now, which picks the context of the next draws
+        void update(double reward, double *statefeats)
+        {
+                double d = reward - baseline[ctx];
+                if ( 0 == rewards[ctx]++ ) {
+                        baseline[ctx] = reward;
+                        d = 0;
+                } else {
+                        baseline[ctx] += d / WINDOW;
+                        spread[ctx] += (fabs(d) - spread[ctx]) / WINDOW;
+                }
+
+                //arms are credited in the context they were drawn in
+                for(int i = 0; i < num_bandits; i++) {
+                        Bandit& b = bandits[i];
+                        int v = b.ctx * b.nvals + b.chosen;
+                        if ( b.count[v] < WINDOW )
+                                b.count[v]++;
+                        b.total[b.ctx]++;
+                        b.mean[v] += (reward - b.mean[v]) / b.count[v];
+                }
+
+                for(int i = 0; i < num_perms; i++) {
+                        Perm& p = perms[i];
+                        if ( spread[p.ctx] > 0 )
+                                updateperm(p, ((p.ctx == ctx) ? d : reward - baseline[p.ctx]) / spread[p.ctx]);
+                }
+
+                ctx = context(statefeats);
+        }
+
+        void sample()
+        {
+                for(int a = 0; a < num_acts; a++)
+                        sample(a);
+        }
+
+        //per context baselines, arm statistics and permutation scores
+        void save(FILE *f)
+        {
+                fprintf(f, "bandit %d %d %d\n", num_bandits, num_perms, num_ctx);
+                for(int c = 0; c < num_ctx; c++)
+                        fprintf(f, "%d %.17g %.17g\n", rewards[c], baseline[c], spread[c]);
+                for(int i = 0; i < num_bandits; i++) {
+                        Bandit& b = bandits[i];
+                        fprintf(f, "%d %d\n", b.nvals, b.chosen);
+                        for(int c = 0; c < num_ctx; c++) {
+                                fprintf(f, "%d", b.total[c]);
+                                for(int v = c * b.nvals; v < (c + 1) * b.nvals; v++)
+                                        fprintf(f, " %d %.17g", b.count[v], b.mean[v]);
+                                fprintf(f, "\n");
+                        }
+                }
+                for(int i = 0; i < num_perms; i++) {
+                        Perm& p = perms[i];
+                        fprintf(f, "%d", p.n);
+                        for(int j = 0; j < p.n * num_ctx; j++)
+                                fprintf(f, " %.17g", p.score[j]);
+                        fprintf(f, "\n");
+                }
+        }
+
+        bool load(FILE *f)
+        {
+                int nb, np, nc;
+                if ( (3 != fscanf(f, " bandit %d %d %d", &nb, &np, &nc)) ||
+                     (nb != num_bandits) || (np != num_perms) || (nc != num_ctx) )
+                        return false;
+                for(int c = 0; c < num_ctx; c++) {
+                        if ( 3 != fscanf(f, "%d %lf %lf", &rewards[c], &baseline[c], &spread[c]) )
+                                return false;
+                }
+                for(int i = 0; i < num_bandits; i++) {
+                        Bandit& b = bandits[i];
+                        int nvals, chosen;
+                        if ( (2 != fscanf(f, "%d %d", &nvals, &chosen)) || (nvals != b.nvals) ||
+                             (chosen < 0) || (chosen >= b.nvals) )
+                                return false;
+                        for(int c = 0; c < num_ctx; c++) {
+                                if ( 1 != fscanf(f, "%d", &b.total[c]) )
+                                        return false;
+                                for(int v = c * b.nvals; v < (c + 1) * b.nvals; v++) {
+                                        if ( 2 != fscanf(f, "%d %lf", &b.count[v], &b.mean[v]) )
+                                                return false;
+                                }
+                        }
+                        b.chosen = chosen;
+                        b.ctx = 0;
+                        *b.val = chosen;
+                }
+                for(int i = 0; i < num_perms; i++) {
+                        Perm& p = perms[i];
+                        int n;
+                        if ( (1 != fscanf(f, "%d", &n)) || (n != p.n) )
+                                return false;
+                        for(int j = 0; j < p.n * num_ctx; j++) {
+                                if ( 1 != fscanf(f, "%lf", &p.score[j]) )
+                                        return false;
+                        }
+                }
+                return true;
+        }
+
+        //every bandit kept drawing its greedy value and every permutation's
+        //scores are settled, in the current context
+        bool converged()
+        {
+                for(int i = 0; i < num_bandits; i++) {
+                        if ( bandits[i].streak < SETTLED )
+                                return false;
+                }
+                for(int i = 0; i < num_perms; i++) {
+                        Perm& p = perms[i];
+                        if ( !settledorder(&p.score[ctx * p.n], p.n, p.ranked) )
+                                return false;
+                }
+                return true;
+        }
+
+        //the best mean tried in the current context; the scores' order
+        void greedy()
+        {
+                for(int i = 0; i < num_bandits; i++) {
+                        Bandit& b = bandits[i];
+                        int* count = &b.count[ctx * b.nvals];
+                        double* mean = &b.mean[ctx * b.nvals];
+                        int best = -1;
+                        for(int v = 0; v < b.nvals; v++) {
+                                if ( (0 != count[v]) && ((best < 0) || (mean[v] > mean[best])) )
+                                        best = v;
+                        }
+                        if ( best >= 0 ) {
+                                b.chosen = best;
+                                b.ctx = ctx;
+                                *b.val = best;
+                        }
+                }
+                for(int i = 0; i < num_perms; i++) {
+                        Perm& p = perms[i];
+                        p.ctx = ctx;
+                        for(int j = 0; j < p.n; j++)
+                                p.order[j] = j;
+                        std::sort(p.order, p.order + p.n, KeyOrder(&p.score[ctx * p.n]));
+                        for(int j = 0; j < p.n; j++)
+                                p.vals[j] = p.order[j];
+                }
+        }
+
+        void sample(int act)
+        {
+                if ( isperm[act] ) {
+                        sampleperm(perms[first[act]]);
+                        return;
+                }
+
+                //an action of first_param values owns that many consecutive bandits
+                for(int i = first[act]; i < first[act] + width[act]; i++)
+                        samplebandit(bandits[i]);
+        }
+};
+
+#endif
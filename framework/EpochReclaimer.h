@@ -0,0 +1,229 @@
+#ifndef __EPOCH_RECLAIMER__
+#define __EPOCH_RECLAIMER__
+
+////////////////////////////////////////////////////////////////////////////////
+// File    : EpochReclaimer.h
+// Author  : agent   email: agent@local
+// Written : 19 October 2026
+//
+// Epoch-based memory reclamation and node reuse for the lock-free data
+// structures. Every operation runs inside a critical section (enter/exit or
+// a Guard). A node that has been unlinked is handed to retire() and parked
+// on the calling thread's limbo list tagged with the global epoch; once the
+// global epoch has moved two steps past that tag no thread can still hold a
+// reference to it, so it is destroyed and its memory goes on the thread's
+// free list for the next alloc().
+//
+// All node memory is cache line aligned (the nodes' members are
+// ATTRIBUTE_CACHE_ALIGNED), so every N that may be retired must come from
+// alloc() and anything not retired must go back through destroy() or
+// release(), never new/delete. MAX_FREE caps each thread's free list;
+// structures with large nodes pass a smaller cap.
+//
+// The global epoch only advances when every thread inside a critical
+// section has observed the current one, so a thread that stalls inside a
+// critical section delays reclamation (but never correctness).
+//
+// Usage:
+//      EpochReclaimer<Node>::Guard guard(_reclaimer, iThread);
+//      Node* nd = new (_reclaimer.alloc(iThread)) Node(x);
+//      ... unlink old ...
+//      _reclaimer.retire(iThread, old);
+//      ...
+//      Node* sentinel = new (EpochReclaimer<Node>::alloc()) Node();
+//      EpochReclaimer<Node>::destroy(sentinel);   //in the destructor
+//
+// Copyright (C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+////////////////////////////////////////////////////////////////////////////////
+// TODO:
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <new>
+#include <vector>
+#include "portable_defns.h"
+#include "cpp_framework.h"
+
+namespace CCP {
+
+	template <class N, int MAX_FREE = 4096>
+	class EpochReclaimer {
+	private:
+
+		//constants -----------------------------------
+		static final int  _NUM_EPOCHS   = 3;
+		static final int  _ADVANCE_FREQ = 0x3f;   //try to advance every 64 critical sections
+
+		//inner classes -------------------------------
+		struct ThreadState {
+			//(epoch<<1)|1 while inside a critical section, 0 otherwise
+			_u64 volatile       _local_epoch  ATTRIBUTE_CACHE_ALIGNED;
+			_u64                _seen_epoch;
+			int                 _ops;
+			_u64                _limbo_epoch[_NUM_EPOCHS];
+			std::vector<N*>     _limbo[_NUM_EPOCHS];
+			std::vector<void*>  _free;
+			char                _pad          ATTRIBUTE_CACHE_ALIGNED;
+
+			ThreadState() : _local_epoch(0), _seen_epoch(0), _ops(0) {
+				for (int i=0; i<_NUM_EPOCHS; ++i)
+					_limbo_epoch[i] = 0;
+			}
+		};
+
+		//fields --------------------------------------
+		final int           _NUM_THREADS  ATTRIBUTE_CACHE_ALIGNED;
+		ThreadState*        _threads;
+		_u64 volatile       _global_epoch ATTRIBUTE_CACHE_ALIGNED;
+		char                _pad          ATTRIBUTE_CACHE_ALIGNED;
+
+		//helper function -----------------------------
+
+		//destroy n; keep its memory for reuse up to MAX_FREE per thread
+		inline_ void recycle(ThreadState& ts, N* final n) {
+			n->~N();
+			if ( (int) ts._free.size() < MAX_FREE )
+				ts._free.push_back((void*) n);
+			else
+				Memory::byte_aligned_free((void*) n);
+		}
+
+		//destroy a retired batch
+		inline_ void flush(ThreadState& ts, final int iEpoch) {
+			std::vector<N*>& limbo = ts._limbo[iEpoch];
+			for (int i=0; i<(int) limbo.size(); ++i)
+				recycle(ts, limbo[i]);
+			limbo.clear();
+		}
+
+		void try_advance(final _u64 epoch) {
+			for (int i=0; i<_NUM_THREADS; ++i) {
+				final _u64 local = _threads[i]._local_epoch;
+				if ( (0 != (local & 1)) && ((local >> 1) != epoch) )
+					return;
+			}
+			CAS(&_global_epoch, epoch, epoch+1);
+		}
+
+	public:
+
+		//RAII critical section
+		class Guard {
+			EpochReclaimer& _r;
+			final int       _iThread;
+		public:
+			Guard(EpochReclaimer& r, final int iThread) : _r(r), _iThread(iThread) { _r.enter(_iThread); }
+			~Guard() { _r.exit(_iThread); }
+		};
+
+		//public operations ---------------------------
+		EpochReclaimer(final int num_threads)
+		:	_NUM_THREADS(num_threads),
+			_global_epoch(0)
+		{
+			_threads = (ThreadState*) Memory::byte_aligned_malloc(sizeof(ThreadState) * _NUM_THREADS, CACHE_LINE_SIZE);
+			for (int i=0; i<_NUM_THREADS; ++i)
+				new (&_threads[i]) ThreadState();
+			Memory::read_write_barrier();
+		}
+
+		//only call once no thread is using the owning data structure
+		~EpochReclaimer() {
+			for (int i=0; i<_NUM_THREADS; ++i) {
+				ThreadState& ts = _threads[i];
+				for (int e=0; e<_NUM_EPOCHS; ++e)
+					flush(ts, e);
+				for (int j=0; j<(int) ts._free.size(); ++j)
+					Memory::byte_aligned_free(ts._free[j]);
+				ts.~ThreadState();
+			}
+			Memory::byte_aligned_free(_threads);
+		}
+
+		inline_ void enter(final int iThread) {
+			ThreadState& ts = _threads[iThread];
+			final _u64 epoch = _global_epoch;
+			ts._local_epoch = (epoch << 1) | 1;
+			//the announcement must be visible before any shared pointer is read
+			Memory::read_write_barrier();
+
+			if ( epoch != ts._seen_epoch ) {
+				ts._seen_epoch = epoch;
+				for (int e=0; e<_NUM_EPOCHS; ++e) {
+					if ( !ts._limbo[e].empty() && (ts._limbo_epoch[e] + 2 <= epoch) )
+						flush(ts, e);
+				}
+			}
+
+			if ( 0 == (++ts._ops & _ADVANCE_FREQ) )
+				try_advance(epoch);
+		}
+
+		inline_ void exit(final int iThread) {
+			Memory::read_write_barrier();
+			_threads[iThread]._local_epoch = 0;
+		}
+
+		//memory for one N; construct it with placement new
+		inline_ void* alloc(final int iThread) {
+			std::vector<void*>& free_list = _threads[iThread]._free;
+			if ( free_list.empty() )
+				return alloc();
+			void* final mem = free_list.back();
+			free_list.pop_back();
+			return mem;
+		}
+
+		//memory for one N outside any thread's free list, e.g. a sentinel
+		inline_ static void* alloc() {
+			return Memory::byte_aligned_malloc(sizeof(N), CACHE_LINE_SIZE);
+		}
+
+		//free an N from alloc() that is not retired, e.g. at teardown
+		inline_ static void destroy(N* final n) {
+			n->~N();
+			Memory::byte_aligned_free((void*) n);
+		}
+
+		//hand back an N that was never published
+		inline_ void release(final int iThread, N* final n) {
+			recycle(_threads[iThread], n);
+		}
+
+		//n must already be unreachable from the data structure. tag it with the
+		//global epoch read after the unlink, not the caller's own epoch: readers
+		//that entered later than the caller may still hold n
+		inline_ void retire(final int iThread, N* final n) {
+			ThreadState& ts = _threads[iThread];
+			final _u64 epoch = _global_epoch;
+			final int iEpoch = (int) (epoch % _NUM_EPOCHS);
+			if ( ts._limbo_epoch[iEpoch] != epoch ) {
+				//whatever is left there is at least 3 epochs old
+				flush(ts, iEpoch);
+				ts._limbo_epoch[iEpoch] = epoch;
+			}
+			ts._limbo[iEpoch].push_back(n);
+		}
+
+		_u64 epoch() {
+			return _global_epoch;
+		}
+	};
+
+}
+
+#endif
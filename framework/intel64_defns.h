@@ -77,8 +77,9 @@ inline void MUTEX_EXIT(unsigned volatile* x) {
 //////////////////////////////////////////////////////////////////////////
 //CPU counters
 //////////////////////////////////////////////////////////////////////////
+//"=A" only means edx:eax on 32-bit x86; here it would drop the high word
 #define RDTICK() \
-	({ tick_t __t; __asm__ __volatile__ ("rdtsc" : "=A" (__t)); __t; })
+	({ unsigned int __lo, __hi; __asm__ __volatile__ ("rdtsc" : "=a" (__lo), "=d" (__hi)); (((tick_t) __hi) << 32) | __lo; })
 
 //////////////////////////////////////////////////////////////////////////
 //bit operations
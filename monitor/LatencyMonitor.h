@@ -0,0 +1,129 @@
+#ifndef __LATENCY_MONITOR__
+#define __LATENCY_MONITOR__
+
+////////////////////////////////////////////////////////////////////////////////
+// File    : LatencyMonitor.h
+// Author  : agent   email: agent@local
+// Written : 19 October 2026
+//
+// A LazyCounter that also measures how long operations take. Each thread
+// keeps its reward count and a log2 histogram of its operation latencies
+// on cache lines of its own, so recording is a couple of plain stores.
+// The learner reads the histograms to optimize a latency percentile or a
+// throughput/latency tradeoff (see LearningEngine::setreward).
+//
+// Usage:
+//      tick_t t = mon->startop();
+//      ... the operation ...
+//      mon->endop(iThread, t);      //one unit of reward and one latency sample
+//
+// Copyright (C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+////////////////////////////////////////////////////////////////////////////////
+
+#include "portable_defns.h"
+#include "cpp_framework.h"
+#include "LazyCounter.h"
+
+
+class LatencyMonitor : public LazyCounter {
+
+private:
+
+        //one per thread; only written by its thread
+        struct Hist {
+                volatile _u64    hist[LATENCY_BUCKETS]  ATTRIBUTE_CACHE_ALIGNED;
+                char             pad                    ATTRIBUTE_CACHE_ALIGNED;
+        };
+
+        Hist*            _hists           ATTRIBUTE_CACHE_ALIGNED;
+
+public:
+
+        //---------------------------------------------------------------------------
+        // LatencyMonitor API
+        //---------------------------------------------------------------------------
+
+        LatencyMonitor(int nthreads)
+        : LazyCounter(nthreads)
+        {
+                _hists = (Hist*) CCP::Memory::byte_aligned_malloc(sizeof(Hist) * _nthreads, CACHE_LINE_SIZE);
+                for(int i = 0; i < _nthreads; i++)
+                        reset(i);
+
+                CCP::Memory::read_write_barrier();
+        }
+
+        ~LatencyMonitor()
+        {
+                CCP::Memory::byte_aligned_free(_hists);
+        }
+
+        inline tick_t startop()
+        {
+                return CCP::System::read_cpu_ticks();
+        }
+
+        //an operation that began at start (see startop) finished, earning amt
+        inline void endop(int tid, tick_t start, _u64 amt = 1)
+        {
+                addlatency(tid, CCP::System::read_cpu_ticks() - start);
+                increment(tid, amt);
+        }
+
+        inline void reset(int tid)
+        {
+                LazyCounter::reset(tid);
+                for(int b = 0; b < LATENCY_BUCKETS; b++)
+                        _hists[tid].hist[b] = 0;
+        }
+
+        //latency at percentile p (0..1) over everything recorded, in ticks
+        double getpercentile(double p)
+        {
+                _u64 hist[LATENCY_BUCKETS];
+                getlatencyhist(hist);
+                return histpercentile(hist, p);
+        }
+
+        //---------------------------------------------------------------------------
+        // Monitor API (the rest is LazyCounter's)
+        //---------------------------------------------------------------------------
+
+        inline void addlatency(int tid, tick_t ticks)
+        {
+                _hists[tid].hist[latencybucket(ticks)]++;
+        }
+
+        bool getlatencyhist(_u64* hist)
+        {
+                for(int b = 0; b < LATENCY_BUCKETS; b++)
+                        hist[b] = 0;
+                for(int i = 0; i < _nthreads; i++) {
+                        for(int b = 0; b < LATENCY_BUCKETS; b++)
+                                hist[b] += _hists[i].hist[b];
+                }
+                return true;
+        }
+
+        final char* name() {
+                return "latencymonitor";
+        }
+
+};
+
+
+#endif
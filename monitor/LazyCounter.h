@@ -33,7 +33,7 @@
 
 class LazyCounter : public Monitor, public FCBase<FCIntPtr> {
 
-private:
+protected:
 
         int              _nthreads        ATTRIBUTE_CACHE_ALIGNED;
         bool             _concurrent;
@@ -25,6 +25,7 @@
 // Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA                  
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <math.h>
 #include "portable_defns.h"
 
 class Monitor {
@@ -46,6 +47,58 @@ public:
 
         virtual _u64 waitchangenotsafe(_u64& changes) = 0;
 
+        // for threads that count their own finished operations (ops, for
+        // thread tid): credits them batch at a time. batch is a power of two
+        inline void addbatchedreward(int tid, int ops, int batch)
+        {
+                if ( 0 == (ops & (batch-1)) )
+                        addreward(tid, batch);
+        }
+
+        // operation latencies, for monitors that measure them (LatencyMonitor).
+        // bucket b counts operations that took [2^b, 2^(b+1)) cpu ticks; the
+        // last bucket takes the rest
+        static const int LATENCY_BUCKETS = 40;
+
+        // records that an operation of thread tid took ticks cpu ticks.
+        // ignored if this monitor doesn't measure latency
+        virtual void addlatency(int tid, tick_t ticks) {}
+
+        // copies the histogram of every latency recorded so far into hist.
+        // false if this monitor doesn't measure latency
+        virtual bool getlatencyhist(_u64* hist) { return false; }
+
+        // the histogram bucket of a latency of t ticks
+        static inline int latencybucket(tick_t t)
+        {
+                int b = 0;
+                while( (t >>= 1) && (b < LATENCY_BUCKETS-1) )
+                        b++;
+                return b;
+        }
+
+        // the latency at percentile p (0..1) of histogram hist, in ticks.
+        // interpolates geometrically inside the bucket; 0 for an empty one
+        static double histpercentile(const _u64* hist, double p)
+        {
+                _u64 total = 0;
+                for(int b = 0; b < LATENCY_BUCKETS; b++)
+                        total += hist[b];
+                if ( 0 == total )
+                        return 0;
+
+                double want = p * total;
+                double seen = 0;
+                for(int b = 0; b < LATENCY_BUCKETS; b++) {
+                        if ( (0 != hist[b]) && (seen + hist[b] >= want) ) {
+                                double frac = (want - seen) / hist[b];
+                                return ldexp(pow(2., frac), b);
+                        }
+                        seen += hist[b];
+                }
+                return ldexp(1., LATENCY_BUCKETS);
+        }
+
 };
 
 #endif
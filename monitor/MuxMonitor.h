@@ -0,0 +1,260 @@
+#ifndef __MUX_MONITOR__
+#define __MUX_MONITOR__
+
+////////////////////////////////////////////////////////////////////////////////
+// File    : MuxMonitor.h
+// Author  : agent   email: agent@local
+// Written : 19 October 2026
+//
+// One reward counter, many channels. Each structure (or each learner) gets
+// a channel of its own, so its learner is credited with that structure's
+// reward only, while the MuxMonitor itself still reads as the aggregate of
+// every channel (plus whatever is added to it directly).
+//
+// Counting is lazy like LazyCounter: each thread owns a block of cache
+// lines holding its reward and change counts for every channel, so adding
+// reward is a plain store to a line nobody else writes and reading sums
+// over the threads. Operation latencies are kept the same way, a log2
+// histogram per thread and channel (see LatencyMonitor), so a channel's
+// learner can tune for its own structure's latency.
+//
+// Usage:
+//      MuxMonitor mux(num_threads, 2);
+//      LearningEngine le0(num_threads, mux.channel(0), ...);
+//      SmartQueue q0(mux.channel(0), &le0);
+//      LearningEngine le1(num_threads, mux.channel(1), ...);
+//      SmartStack s1(mux.channel(1), &le1);
+//      ... mux.getreward() is the total ...
+//
+// Copyright (C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+////////////////////////////////////////////////////////////////////////////////
+
+#include <assert.h>
+#include "portable_defns.h"
+#include "cpp_framework.h"
+#include "Monitor.h"
+
+
+class MuxMonitor : public Monitor {
+
+public:
+
+        //a view of one channel
+        class Channel : public Monitor {
+        private:
+                MuxMonitor*  _mux;
+                int          _ch;
+
+                friend class MuxMonitor;
+
+        public:
+                Channel(): _mux(NULL), _ch(0) {}
+
+                inline _u64 waitchangenotsafe(_u64& changes) { return _mux->waitchange(_ch, changes); }
+
+                inline _u64 getrewardnotsafe() { _u64 changes; return _mux->get(_ch, changes); }
+
+                inline _u64 getreward() { _u64 changes; return _mux->get(_ch, changes); }
+
+                inline _u64 getrewardnotsafe(_u64& changes) { return _mux->get(_ch, changes); }
+
+                inline _u64 getreward(_u64& changes) { return _mux->get(_ch, changes); }
+
+                inline void addrewardnotsafe(int tid, _u64 amt) { _mux->increment(tid, _ch, amt); }
+
+                inline void addreward(int tid, _u64 amt) { _mux->increment(tid, _ch, amt); }
+
+                inline void addlatency(int tid, tick_t ticks) { _mux->latency(tid, _ch, ticks); }
+
+                bool getlatencyhist(_u64* hist) { _mux->gethist(_ch, hist); return true; }
+        };
+
+private:
+
+        static final int   ALL            = -1;
+
+        int                _nthreads      ATTRIBUTE_CACHE_ALIGNED;
+        int                _nchannels;
+        int                _stride;       //_u64s per thread block
+        _u64*              _counters;     //per thread: reward, changes for each channel, then the direct ones
+        int                _hstride;      //_u64s per thread block of histograms
+        _u64*              _hists;        //per thread: a latency histogram for each channel, then the direct one
+        Channel*           _channels;
+
+        //backoff settings in nanoseconds
+        static final _u64  BACKOFF_START  = 100;
+        static final _u64  BACKOFF_MAX    = 6400;
+
+        char pad                          ATTRIBUTE_CACHE_ALIGNED;
+
+        inline volatile _u64* slot(int tid, int ch)
+        {
+                return &_counters[tid * _stride + 2 * ch];
+        }
+
+        inline volatile _u64* hist(int tid, int ch)
+        {
+                return &_hists[tid * _hstride + LATENCY_BUCKETS * ch];
+        }
+
+public:
+
+        //---------------------------------------------------------------------------
+        // MuxMonitor API
+        //---------------------------------------------------------------------------
+
+        MuxMonitor(int nthreads, int nchannels)
+        : _nthreads(nthreads),
+          _nchannels(nchannels)
+        {
+                //one more pair for reward added to the aggregate directly
+                int bytes = 2 * (nchannels + 1) * sizeof(_u64);
+                _stride = ((bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE / sizeof(_u64);
+                _counters = (_u64*) CCP::Memory::byte_aligned_malloc(_stride * sizeof(_u64) * _nthreads, CACHE_LINE_SIZE);
+                for(int i = 0; i < _stride * _nthreads; i++)
+                        _counters[i] = 0;
+
+                bytes = LATENCY_BUCKETS * (nchannels + 1) * sizeof(_u64);
+                _hstride = ((bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE / sizeof(_u64);
+                _hists = (_u64*) CCP::Memory::byte_aligned_malloc(_hstride * sizeof(_u64) * _nthreads, CACHE_LINE_SIZE);
+                for(int i = 0; i < _hstride * _nthreads; i++)
+                        _hists[i] = 0;
+
+                _channels = new Channel[nchannels];
+                for(int c = 0; c < nchannels; c++) {
+                        _channels[c]._mux = this;
+                        _channels[c]._ch = c;
+                }
+
+                CCP::Memory::read_write_barrier();
+        }
+
+        ~MuxMonitor()
+        {
+                delete[] _channels;
+                CCP::Memory::byte_aligned_free(_hists);
+                CCP::Memory::byte_aligned_free(_counters);
+        }
+
+        //the channel's Monitor; lives as long as the MuxMonitor
+        inline Monitor* channel(int ch)
+        {
+                assert( (ch >= 0) && (ch < _nchannels) );
+                return &_channels[ch];
+        }
+
+        inline int numchannels()
+        {
+                return _nchannels;
+        }
+
+        inline void increment(int tid, int ch, _u64 iAmt)
+        {
+                //assume each thread's block is only written by that thread
+                if ( iAmt != 0 ) {
+                        volatile _u64* s = slot(tid, ch);
+                        s[0] += iAmt;
+                        s[1] += 1;
+                }
+        }
+
+        //one channel's totals, or every channel's (and the direct reward) for ALL
+        inline _u64 get(int ch, _u64& changes)
+        {
+                int lo = (ALL == ch) ? 0 : ch;
+                int hi = (ALL == ch) ? _nchannels : ch;
+                _u64 sum = 0;
+                changes = 0;
+                for(int i = 0; i < _nthreads; i++) {
+                        for(int c = lo; c <= hi; c++) {
+                                volatile _u64* s = slot(i, c);
+                                sum += s[0];
+                                changes += s[1];
+                        }
+                }
+                return sum;
+        }
+
+        inline void latency(int tid, int ch, tick_t ticks)
+        {
+                //assume each thread's block is only written by that thread
+                hist(tid, ch)[latencybucket(ticks)]++;
+        }
+
+        //one channel's latency histogram, or every channel's for ALL
+        inline void gethist(int ch, _u64* h)
+        {
+                int lo = (ALL == ch) ? 0 : ch;
+                int hi = (ALL == ch) ? _nchannels : ch;
+                for(int b = 0; b < LATENCY_BUCKETS; b++)
+                        h[b] = 0;
+                for(int i = 0; i < _nthreads; i++) {
+                        for(int c = lo; c <= hi; c++) {
+                                volatile _u64* s = hist(i, c);
+                                for(int b = 0; b < LATENCY_BUCKETS; b++)
+                                        h[b] += s[b];
+                        }
+                }
+        }
+
+        inline _u64 waitchange(int ch, _u64& changes)
+        {
+                //check if changed. if so return newval.
+                _u64 lastchanges = changes;
+                _u64 newval = get(ch, changes);
+                if ( changes != lastchanges )
+                        return newval;
+
+                //spin with backoff until val changes
+                _u64 backoff = BACKOFF_START;
+                do {
+                        CCP::Thread::delay(backoff);
+                        backoff <<= 1;
+                        if ( backoff > BACKOFF_MAX )
+                                backoff = BACKOFF_START;
+                        newval = get(ch, changes);
+                } while( changes == lastchanges );
+
+                return newval;
+        }
+
+        //---------------------------------------------------------------------------
+        // Monitor API (the aggregate)
+        //---------------------------------------------------------------------------
+
+        inline _u64 waitchangenotsafe(_u64& changes) { return waitchange(ALL, changes); }
+
+        inline _u64 getrewardnotsafe() { _u64 changes; return get(ALL, changes); }
+
+        inline _u64 getreward() { _u64 changes; return get(ALL, changes); }
+
+        inline _u64 getrewardnotsafe(_u64& changes) { return get(ALL, changes); }
+
+        inline _u64 getreward(_u64& changes) { return get(ALL, changes); }
+
+        inline void addrewardnotsafe(int tid, _u64 amt) { increment(tid, _nchannels, amt); }
+
+        inline void addreward(int tid, _u64 amt) { increment(tid, _nchannels, amt); }
+
+        inline void addlatency(int tid, tick_t ticks) { latency(tid, _nchannels, ticks); }
+
+        bool getlatencyhist(_u64* h) { gethist(ALL, h); return true; }
+
+};
+
+
+#endif
@@ -58,6 +58,11 @@ public:
 
         float   _rl_to_sleepidle_ratio;
         int     _internal_reward_mode;
+        //optional, 0 if not given ..........................
+        int     _reward_mode;                 //0 throughput, 1 p99 latency, 2 both (see LearningEngine::setreward)
+        int     _warmstart;                   //1: learners start from, and save, the last run's policy
+        int     _policy_freezing;             //1: learners stop exploring once the reward settles
+        int     _helpers;                     //learning helper threads; 0 for the default (one)
 
         //..................................................
         bool read() {
@@ -69,6 +74,10 @@ public:
                                               &_is_dedicated_mode, &_tm_status, &_read_write_delay, &_fc_passes, &_barrier_interval, 
                                               &_scancount_tuning, &_lock_scheduling, &_dynamic_work_size, &_dynamic_work_intervals,
                                               &_rl_to_sleepidle_ratio, &_internal_reward_mode );
+                        _reward_mode = 0;
+                        _warmstart = 0;
+                        _policy_freezing = 0;
+                        _helpers = 0;
 
                         return (26 == num_read);
                 } catch (...) {
@@ -108,6 +117,10 @@ public:
                         _dynamic_work_intervals = CCP::Integer::parseInt(argv[curr_arg++]);
                         _rl_to_sleepidle_ratio  = (float)atof(argv[curr_arg++]);
                         _internal_reward_mode   = CCP::Integer::parseInt(argv[curr_arg++]);
+                        _reward_mode            = (curr_arg < argc) ? CCP::Integer::parseInt(argv[curr_arg++]) : 0;
+                        _warmstart              = (curr_arg < argc) ? CCP::Integer::parseInt(argv[curr_arg++]) : 0;
+                        _policy_freezing        = (curr_arg < argc) ? CCP::Integer::parseInt(argv[curr_arg++]) : 0;
+                        _helpers                = (curr_arg < argc) ? CCP::Integer::parseInt(argv[curr_arg++]) : 0;
 
                         return true;
                 } catch (...) {
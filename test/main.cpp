@@ -37,13 +37,16 @@
 #include "Configuration.h"
 #include "Heartbeat.h"
 #include "LazyCounter.h"
+#include "LatencyMonitor.h"
+#include "MuxMonitor.h"
 
 //FC research includes .................................
 //queues
 #include "SmartQueue.h"
 #include "MSQueue.h"
 #include "BasketsQueue.h"
-//#include "ComTreeQueue.h"
+#include "FAAQueue.h"
+#include "ComTreeQueue.h"
 #include "OyamaQueue.h"
 //#include "MutexQueue.h"
 //#include "OyamaQueueCom.h"
@@ -54,9 +57,10 @@
 //pairheaps
 #include "SmartPairingHeap.h"
 #include "MutexPairingHeap.h"
+#include "SmartMultiHeap.h"
 //stacks
 #include "FCStack.h"
-//#include "SmartStack.h"  //doesn't exist yet
+#include "SmartStack.h"
 #include "LFStack.h"
 #include "EliminationStack.h"
 
@@ -104,8 +108,14 @@ static tick_t                           _gResultPeek = 0L;
 static _u64 volatile                    _seed;
 static boolean                          _is_tm=false;
 static boolean                          _is_view=false;
+static boolean                          _is_latency=false;        //time each ds op for the learners
 
-static Monitor*                         _mon;
+static Monitor*                         _mon;                     //reward of the whole run
+static MuxMonitor*                      _mux;                     //its channels; null for a lone Hb
+static final int                        _num_groups                = 4;
+static Monitor*                         _gChan[1024];             //reward channel of each ds
+static int                              _gGroupDS[_num_groups];   //ds in each algorithm group
+static LearningEngine*                  _gLearner[_num_groups];   //learner of each algorithm group
 
 static final int                        _num_work_amts             = 10;
 //static int                            _work_amts[_num_work_amts] = {800, 6400, 200, 3200, 1600, 100, 400, 100, 400, 800};
@@ -120,7 +130,16 @@ void RunBenchmark();
 void PrepareActions();
 void PrepareRandomNumbers(final int size);
 int NearestPowerOfTwo(final int x);
-FCBase<FCIntPtr>* CreateDataStructure(char* final alg_name, LearningEngine* learner);
+FCBase<FCIntPtr>* CreateDataStructure(char* final alg_name, Monitor* mon, LearningEngine* learner);
+void AddReward(final int thread_no);
+int NumTuneKnobs(char* final alg_name);
+int NumTuneKnobs(char* final alg_name, final int mode);
+boolean RewardsFromAnyThread(char* final alg_name);
+Monitor* GroupMonitor(final int group);
+void SetReward(LearningEngine* learner);
+void WarmStart(final int group, char* final alg_name);
+tick_t StartOp();
+void EndOp(final int thread_no, final int iDb, final tick_t start);
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -172,34 +191,40 @@ public:
                         if(1==op) {
                                 for (int iDb=0; iDb<_num_ds; ++iDb) {
                                         *n = FCIntPtrNode( _gRandNumAry[iNumAdd] );
+                                        final tick_t start = StartOp();
                                         final int enq_value = _gDS[iDb]->add(_threadNo, n);
+                                        EndOp(_threadNo, iDb, start);
                                         ++iNumAdd;
                                         if(iNumAdd >= _gTotalRandNum)
                                                 iNumAdd=0;
                                 }
                                 ++action_counter;
                                 if ( 0 == _gConfiguration._internal_reward_mode )
-				        _mon->addreward(_threadNo, _num_ds);
+				        AddReward(_threadNo);
                         } else if(2==op) {
                                 for (int iDb=0; iDb<_num_ds; ++iDb) {
                                         *n = FCIntPtrNode( _gRandNumAry[iNumRemove] );
+                                        final tick_t start = StartOp();
                                         PtrNode<FCIntPtr>* final deq_value = _gDS[iDb]->remove(_threadNo, n);
+                                        EndOp(_threadNo, iDb, start);
                                         ++iNumRemove;
                                         if(iNumRemove >= _gTotalRandNum) { iNumRemove=0; }
                                 }
                                 ++action_counter;
                                 if ( 0 == _gConfiguration._internal_reward_mode )
-				        _mon->addreward(_threadNo, _num_ds);
+				        AddReward(_threadNo);
                         } else {
                                 for (int iDb=0; iDb<_num_ds; ++iDb) {
                                         *n = FCIntPtrNode( _gRandNumAry[iNumContain] );
+                                        final tick_t start = StartOp();
                                         _gDS[iDb]->contain(_threadNo, n);
+                                        EndOp(_threadNo, iDb, start);
                                         ++iNumContain;
                                         if(iNumContain >= _gTotalRandNum) {     iNumContain=0; }
                                 }
                                 ++action_counter;
                                 if ( 0 == _gConfiguration._internal_reward_mode )
-				        _mon->addreward(_threadNo, _num_ds);
+				        AddReward(_threadNo);
                         }
 
                         ++iOp;
@@ -262,14 +287,16 @@ public:
 
 		        //for (int iDb=0; iDb<_num_ds; ++iDb) {
                                 *n = FCIntPtrNode( _gRandNumAry[iNumAdd] );
+                                final tick_t start = StartOp();
                                 final int enq_value = _gDS[iDb]->add(_threadNo, n);
+                                EndOp(_threadNo, iDb, start);
                                 ++iNumAdd;
                                 if(iNumAdd >= _gTotalRandNum)
                                 iNumAdd=0;
 			//}
                         ++action_counter;
                         if ( 0 == _gConfiguration._internal_reward_mode )
-				_mon->addreward(_threadNo, 1);
+				_gChan[iDb]->addreward(_threadNo, 1);
 
                         /*
                         if (_gConfiguration._read_write_delay > 0) {
@@ -326,13 +353,15 @@ public:
 
                 do {
 		        //for (int iDb=0; iDb<_num_ds; ++iDb) {
+                                final tick_t start = StartOp();
                                 while ( (0 == _gIsStopThreads) && (0 == _gDS[iDb]->remove(_threadNo, NULL)) );  
+                                EndOp(_threadNo, iDb, start);
                                 ++iNumRemove;
                                 if(iNumRemove >= _gTotalRandNum) { iNumRemove=0; }
 			//}
                         ++action_counter;
                         if ( 0 == _gConfiguration._internal_reward_mode )
-				_mon->addreward(_threadNo, 1);
+				_gChan[iDb]->addreward(_threadNo, 1);
 
                         if (_gConfiguration._read_write_delay > 0) {
                                 _gDS[0]->post_computation(_threadNo);
@@ -392,13 +421,15 @@ public:
                 do {
 		        //for (int iDb=0; iDb<_num_ds; ++iDb) {
 		                //*n = FCIntPtrNode( _gRandNumAry[iNumContain] );
+                                final tick_t start = StartOp();
 		                last = (_u64) _gDS[iDb]->contain(_threadNo, (FCIntPtrNode*) last);
+                                EndOp(_threadNo, iDb, start);
                                 ++iNumContain;
                                 if(iNumContain >= _gTotalRandNum) {     iNumContain=0; }
 		        //}
                         ++action_counter;
                         if ( 0 == _gConfiguration._internal_reward_mode )
-				_mon->addreward(_threadNo, 1);
+				_gChan[iDb]->addreward(_threadNo, 1);
 
                         if (_gConfiguration._read_write_delay > 0) {
                                 _gDS[0]->post_computation(_threadNo);
@@ -445,17 +476,33 @@ int main(int argc, char **argv) {
         }
 
         //initialize global variables ..............................................
-        int tmp = _gConfiguration._alg1_num + _gConfiguration._alg2_num + _gConfiguration._alg3_num + _gConfiguration._alg4_num;
-        bool concurrent = (tmp != 1) || (0 == _gConfiguration._internal_reward_mode);
-
         _gNumProcessors     = 1; //Runtime.getRuntime().availableProcessors();
         _gNumThreads        = _gConfiguration._no_of_threads;
         _gIsDedicatedMode   = _gConfiguration._is_dedicated_mode;
         _gTotalRandNum      = Math::Max(_gConfiguration._capacity, 4*1024*1024);
         _gThroughputTime    = _gConfiguration._throughput_time;
 
-        _mon = new Hb(concurrent);
-        //_mon = new LazyCounter(_gNumThreads, concurrent);
+        int tmp = _gConfiguration._alg1_num + _gConfiguration._alg2_num + _gConfiguration._alg3_num + _gConfiguration._alg4_num;
+        char* final alg_name = (0 != _gConfiguration._alg1_num) ? _gConfiguration._alg1_name :
+                               (0 != _gConfiguration._alg2_num) ? _gConfiguration._alg2_name :
+                               (0 != _gConfiguration._alg3_num) ? _gConfiguration._alg3_name : _gConfiguration._alg4_name;
+        bool concurrent = (tmp != 1) || (0 == _gConfiguration._internal_reward_mode) || RewardsFromAnyThread(alg_name);
+        _is_latency = (0 != _gConfiguration._reward_mode);
+
+        //a single structure that rewards itself from one thread at a time keeps
+        //the non-concurrent Hb (a LatencyMonitor if latencies are measured).
+        //otherwise use one reward channel per algorithm group, so each group's
+        //learner is credited with its own structures' work only
+        if ( concurrent ) {
+                _mux = new MuxMonitor(_gNumThreads, _num_groups);
+                _mon = _mux;
+        } else if ( _is_latency ) {
+                _mux = null;
+                _mon = new LatencyMonitor(_gNumThreads);
+        } else {
+                _mux = null;
+                _mon = new Hb(false);
+        }
 
         //prepare the random numbers ...............................................
         System_err_println("");
@@ -475,7 +522,18 @@ int main(int argc, char **argv) {
         } else {
                 System_out_format(" *%4d* *%4d* *%4d*", (unsigned int)_gResultAdd, (unsigned int)_gResultRemove, (unsigned int)_gResultPeek);
         }
+        if ( _is_latency ) {
+                _u64 hist[Monitor::LATENCY_BUCKETS];
+                _mon->getlatencyhist(hist);
+                printf(" *p50 %.0f p99 %.0f*", Monitor::histpercentile(hist, .5), Monitor::histpercentile(hist, .99));
+        }
         Thread::sleep(1*1000);
+        for (int g=0; g<_num_groups; ++g) {
+                if ( (null != _gLearner[g]) && (0 != _gConfiguration._warmstart) )
+                        _gLearner[g]->savepolicy();
+                if ( (null != _gLearner[g]) && (0 != _gConfiguration._policy_freezing) )
+                        System_err_println("    group " + Integer::toString(g) + " frozen: " + Integer::toString(_gLearner[g]->isfrozen() ? 1 : 0));
+        }
         for (int iDb=0; iDb<_num_ds; ++iDb) {
                 _gDS[iDb]->print_custom();
                 printf(" **%d %d**", (_gEndTime - _gStartTime), _gResult * (_gEndTime - _gStartTime));
@@ -492,6 +550,47 @@ int main(int argc, char **argv) {
 ////////////////////////////////////////////////////////////////////////////////
 //HELPER FUNCTIONS
 ////////////////////////////////////////////////////////////////////////////////
+//one unit of reward per structure touched, credited to each group's channel
+void AddReward(final int thread_no) {
+        for (int g=0; g<_num_groups; ++g) {
+                if ( 0 != _gGroupDS[g] )
+                        GroupMonitor(g)->addreward(thread_no, _gGroupDS[g]);
+        }
+}
+
+//what the learners optimize, from the reward_mode setting
+void SetReward(LearningEngine* learner) {
+        if ( (null == learner) || !_is_latency )
+                return;
+        if ( !learner->setreward((LearningEngine::reward_mode_t) _gConfiguration._reward_mode) ) {
+                System_err_println("The reward monitor does not measure latency");
+                exit(0);
+        }
+}
+
+//with warmstart, a group's learner starts from the policy the last run with
+//the same algorithm in the same group left behind (saved at the end of main).
+//its structures have registered their knobs by now
+void WarmStart(final int group, char* final alg_name) {
+        if ( (null == _gLearner[group]) || (0 == _gConfiguration._warmstart) )
+                return;
+        char name[1024+16];
+        snprintf(name, sizeof(name), "%s.g%d", alg_name, group);
+        if ( _gLearner[group]->warmstart(name) )
+                System_err_println("    warm started " + std::string(name));
+}
+
+//in latency mode, the time of one operation on structure iDb is recorded on
+//its reward channel: tick_t start = StartOp(); ...op...; EndOp(tid, iDb, start);
+tick_t StartOp() {
+        return _is_latency ? System::read_cpu_ticks() : 0;
+}
+
+void EndOp(final int thread_no, final int iDb, final tick_t start) {
+        if ( _is_latency )
+                _gChan[iDb]->addlatency(thread_no, System::read_cpu_ticks() - start);
+}
+
 void RunBenchmark() {
         //print test information ...................................................
         System_err_println("Benchmark Curr: ");
@@ -523,6 +622,10 @@ void RunBenchmark() {
         System_err_println("    dynamic_work_size:      " + Integer::toString(_gConfiguration._dynamic_work_size));
         System_err_println("    dynamic_work_intervals: " + Integer::toString(_gConfiguration._dynamic_work_intervals));
         System_err_println("    internal_reward_mode:   " + Integer::toString(_gConfiguration._internal_reward_mode));
+        System_err_println("    reward_mode:            " + Integer::toString(_gConfiguration._reward_mode) + (std::string)("   (0=Throughput; 1=p99 Latency; 2=Both)"));
+        System_err_println("    warmstart:              " + Integer::toString(_gConfiguration._warmstart));
+        System_err_println("    policy_freezing:        " + Integer::toString(_gConfiguration._policy_freezing));
+        System_err_println("    helpers:                " + Integer::toString(_gConfiguration._helpers));
 
         _is_view = (0 != _gConfiguration._tm_status);
 
@@ -540,6 +643,12 @@ void RunBenchmark() {
         FCBase<FCIntPtr>::_dynamic_work_size = _gConfiguration._dynamic_work_size;
         FCBase<FCIntPtr>::_dynamic_work_intervals = _gConfiguration._dynamic_work_intervals;
 
+        //spread the groups' learners over several helper threads ................
+        if ( (0 != _gConfiguration._helpers) && !LearningEngine::sethelpers(_gConfiguration._helpers) ) {
+                System_err_println("Invalid number of learning helpers: " + Integer::toString(_gConfiguration._helpers));
+                exit(0);
+        }
+
         //create appropriate data-structure ........................................
 	LearningEngine *learner;
         _num_ds=0;
@@ -549,76 +658,100 @@ void RunBenchmark() {
         int num_sc_tune = 0;
         if ( 0   != _gConfiguration._lock_scheduling )  { mode |= LearningEngine::lock_scheduling;  num_lock_sched = 1; }
         if ( 0   != _gConfiguration._scancount_tuning ) { mode |= LearningEngine::scancount_tuning; num_sc_tune    = 1; }
+        if ( 2   == _gConfiguration._scancount_tuning ) { mode |= LearningEngine::lock_alg_tuning; }
+        if ( 3   == _gConfiguration._scancount_tuning ) { mode |= LearningEngine::bandit_tuning; }
         if ( 1.0 != _gConfiguration._rl_to_sleepidle_ratio )   { mode |= LearningEngine::inject_delay; }
+        if ( (0 != _gConfiguration._policy_freezing) && (0 != (mode & (LearningEngine::lock_scheduling | LearningEngine::scancount_tuning))) )
+                mode |= LearningEngine::policy_freezing;
 
 
 	if ( 0 == strncmp(_gConfiguration._alg1_name, "smart", 5) )
-                learner = new LearningEngine(_gNumThreads, _mon, _gConfiguration._rl_to_sleepidle_ratio,
+                learner = new LearningEngine(_gNumThreads, GroupMonitor(0), _gConfiguration._rl_to_sleepidle_ratio,
 					     (LearningEngine::learning_mode_t) mode, 
-                                             num_lock_sched*_gConfiguration._alg1_num, num_sc_tune*_gConfiguration._alg1_num );
+                                             num_lock_sched*_gConfiguration._alg1_num, num_sc_tune*NumTuneKnobs(_gConfiguration._alg1_name, mode)*_gConfiguration._alg1_num );
 	else
 	        learner = null;
+        SetReward(learner);
 
         for (int i=0; i<(_gConfiguration._alg1_num); ++i) {
-	        FCBase<FCIntPtr>* tmp = CreateDataStructure(_gConfiguration._alg1_name, learner);
+	        FCBase<FCIntPtr>* tmp = CreateDataStructure(_gConfiguration._alg1_name, GroupMonitor(0), learner);
                 if ( tmp == null ) {
                    System_err_println("Invalid data structure type requested: " + std::string(_gConfiguration._alg1_name));
                    exit(0);
                 }
+                _gChan[_num_ds] = GroupMonitor(0);
                 _gDS[_num_ds++] = tmp;
+                ++_gGroupDS[0];
         }
+        _gLearner[0] = learner;
+        WarmStart(0, _gConfiguration._alg1_name);
 
 
 	if ( 0 == strncmp(_gConfiguration._alg2_name, "smart", 5) )
-                learner = new LearningEngine(_gNumThreads, _mon, _gConfiguration._rl_to_sleepidle_ratio,
+                learner = new LearningEngine(_gNumThreads, GroupMonitor(1), _gConfiguration._rl_to_sleepidle_ratio,
 					     (LearningEngine::learning_mode_t) mode, 
-                                             num_lock_sched*_gConfiguration._alg2_num, num_sc_tune*_gConfiguration._alg2_num );
+                                             num_lock_sched*_gConfiguration._alg2_num, num_sc_tune*NumTuneKnobs(_gConfiguration._alg2_name, mode)*_gConfiguration._alg2_num );
 	else
 	        learner = null;
+        SetReward(learner);
 
 
         for (int i=0; i<(_gConfiguration._alg2_num); ++i) {
-	        FCBase<FCIntPtr>* tmp = CreateDataStructure(_gConfiguration._alg2_name, learner);
+	        FCBase<FCIntPtr>* tmp = CreateDataStructure(_gConfiguration._alg2_name, GroupMonitor(1), learner);
                 if ( tmp == null ) {
                    System_err_println("Invalid data structure type requested: " + std::string(_gConfiguration._alg2_name));
                    exit(0);
                 }
+                _gChan[_num_ds] = GroupMonitor(1);
                 _gDS[_num_ds++] = tmp;
+                ++_gGroupDS[1];
         }
+        _gLearner[1] = learner;
+        WarmStart(1, _gConfiguration._alg2_name);
 
 
 	if ( 0 == strncmp(_gConfiguration._alg3_name, "smart", 5) )
-                learner = new LearningEngine(_gNumThreads, _mon, _gConfiguration._rl_to_sleepidle_ratio,
+                learner = new LearningEngine(_gNumThreads, GroupMonitor(2), _gConfiguration._rl_to_sleepidle_ratio,
 					     (LearningEngine::learning_mode_t) mode, 
-                                             num_lock_sched*_gConfiguration._alg3_num, num_sc_tune*_gConfiguration._alg3_num );
+                                             num_lock_sched*_gConfiguration._alg3_num, num_sc_tune*NumTuneKnobs(_gConfiguration._alg3_name, mode)*_gConfiguration._alg3_num );
 	else
 	        learner = null;
+        SetReward(learner);
 
         for (int i=0; i<(_gConfiguration._alg3_num); ++i) {
-	        FCBase<FCIntPtr>* tmp = CreateDataStructure(_gConfiguration._alg3_name, learner);
+	        FCBase<FCIntPtr>* tmp = CreateDataStructure(_gConfiguration._alg3_name, GroupMonitor(2), learner);
                 if ( tmp == null ) {
                    System_err_println("Invalid data structure type requested: " + std::string(_gConfiguration._alg3_name));
                    exit(0);
                 }
+                _gChan[_num_ds] = GroupMonitor(2);
                 _gDS[_num_ds++] = tmp;
+                ++_gGroupDS[2];
         }
+        _gLearner[2] = learner;
+        WarmStart(2, _gConfiguration._alg3_name);
 
 
 	if ( 0 == strncmp(_gConfiguration._alg4_name, "smart", 5) )
-                learner = new LearningEngine(_gNumThreads, _mon, _gConfiguration._rl_to_sleepidle_ratio,
+                learner = new LearningEngine(_gNumThreads, GroupMonitor(3), _gConfiguration._rl_to_sleepidle_ratio,
 					     (LearningEngine::learning_mode_t) mode, 
-                                             num_lock_sched*_gConfiguration._alg4_num, num_sc_tune*_gConfiguration._alg4_num );
+                                             num_lock_sched*_gConfiguration._alg4_num, num_sc_tune*NumTuneKnobs(_gConfiguration._alg4_name, mode)*_gConfiguration._alg4_num );
 	else
 	        learner = null;
+        SetReward(learner);
 
         for (int i=0; i<(_gConfiguration._alg4_num); ++i) {
-	        FCBase<FCIntPtr>* tmp = CreateDataStructure(_gConfiguration._alg4_name, learner);
+	        FCBase<FCIntPtr>* tmp = CreateDataStructure(_gConfiguration._alg4_name, GroupMonitor(3), learner);
                 if ( tmp == null ) {
                    System_err_println("Invalid data structure type requested: " + std::string(_gConfiguration._alg4_name));
                    exit(0);
                 }
+                _gChan[_num_ds] = GroupMonitor(3);
                 _gDS[_num_ds++] = tmp;
+                ++_gGroupDS[3];
         }
+        _gLearner[3] = learner;
+        WarmStart(3, _gConfiguration._alg4_name);
 
 
         //install work amount
@@ -752,7 +885,58 @@ void RunBenchmark() {
         _gResultPeek     /= (long)(_gEndTime - _gStartTime);
 }
 
-FCBase<FCIntPtr>* CreateDataStructure(char* final alg_name, LearningEngine* learner) {
+//the reward of algorithm group group
+Monitor* GroupMonitor(final int group) {
+        return (null != _mux) ? _mux->channel(group) : _mon;
+}
+
+//the class behind each learned structure, for reading its properties
+//(see FCBase::_NUM_TUNE_KNOBS) before CreateDataStructure builds it
+template <class DS>
+void GetProps(int& knobs, boolean& any_thread) {
+        knobs = DS::_NUM_TUNE_KNOBS;
+        any_thread = DS::_REWARDS_FROM_ANY_THREAD;
+}
+
+void StructureProps(char* final alg_name, int& knobs, boolean& any_thread) {
+        if(0 == strcmp(alg_name, "smartmsqueue"))
+                GetProps<MSQueue<FCIntPtr,true,true> >(knobs, any_thread);
+        else if(0 == strcmp(alg_name, "smartbasketsqueue"))
+                GetProps<BasketsQueue<FCIntPtr,true,true> >(knobs, any_thread);
+        else if(0 == strcmp(alg_name, "smartctqueue"))
+                GetProps<ComTreeQueue<FCIntPtr,true,true> >(knobs, any_thread);
+        else if(0 == strcmp(alg_name, "smartmultiheap"))
+                GetProps<SmartMultiHeap<FCIntPtr,true,true> >(knobs, any_thread);
+        else if(0 == strcmp(alg_name, "smartelstack"))
+                GetProps<EliminationStack<FCIntPtr,true,true> >(knobs, any_thread);
+        else    //the flat combining structures
+                GetProps<FCBase<FCIntPtr> >(knobs, any_thread);
+}
+
+//true if the structure's own reward is added by every thread that uses it
+//rather than by one thread at a time (a combiner or the root lock holder)
+boolean RewardsFromAnyThread(char* final alg_name) {
+        int knobs;
+        boolean any_thread;
+        StructureProps(alg_name, knobs, any_thread);
+        return any_thread;
+}
+
+//number of discrete knobs each instance registers with its learner
+int NumTuneKnobs(char* final alg_name) {
+        int knobs;
+        boolean any_thread;
+        StructureProps(alg_name, knobs, any_thread);
+        return knobs;
+}
+
+//knobs each instance registers, counting the SmartLockLite algorithm knob when
+//it is learned. structures without a SmartLockLite leave that one unused
+int NumTuneKnobs(char* final alg_name, final int mode) {
+        return NumTuneKnobs(alg_name) + ((0 != (mode & LearningEngine::lock_alg_tuning)) ? 1 : 0);
+}
+
+FCBase<FCIntPtr>* CreateDataStructure(char* final alg_name, Monitor* mon, LearningEngine* learner) {
 
         //queue ....................................................................
         if(0 == strcmp(alg_name, "fcqueue")) {
@@ -760,9 +944,9 @@ FCBase<FCIntPtr>* CreateDataStructure(char* final alg_name, LearningEngine* lear
         }
         if(0 == strcmp(alg_name, "smartqueue")) {
 	        if ( 0 != _gConfiguration._internal_reward_mode ) 
-	                return (new SmartQueue<FCIntPtr,true,true>(_mon, learner));
+	                return (new SmartQueue<FCIntPtr,true,true>(mon, learner));
 		else
-		        return (new SmartQueue<FCIntPtr,true,false>(_mon, learner));
+		        return (new SmartQueue<FCIntPtr,true,false>(mon, learner));
         }
         if(0 == strcmp(alg_name, "msqueue")) {
                 return (new MSQueue<FCIntPtr>());
@@ -770,10 +954,30 @@ FCBase<FCIntPtr>* CreateDataStructure(char* final alg_name, LearningEngine* lear
         if(0 == strcmp(alg_name, "basketsqueue")) {
                 return (new BasketsQueue<FCIntPtr>());
         }
-        //not working yet
-        //if(0 == strcmp(alg_name, "ctqueue")) {
-        //        return (new ComTreeQueue<FCIntPtr>());
-        //}
+        if(0 == strcmp(alg_name, "smartmsqueue")) {
+	        if ( 0 != _gConfiguration._internal_reward_mode ) 
+	                return (new MSQueue<FCIntPtr,true,true>(mon, learner));
+		else
+		        return (new MSQueue<FCIntPtr,true,false>(mon, learner));
+        }
+        if(0 == strcmp(alg_name, "smartbasketsqueue")) {
+	        if ( 0 != _gConfiguration._internal_reward_mode ) 
+	                return (new BasketsQueue<FCIntPtr,true,true>(0, mon, learner));
+		else
+		        return (new BasketsQueue<FCIntPtr,true,false>(0, mon, learner));
+        }
+        if(0 == strcmp(alg_name, "faaqueue")) {
+                return (new FAAQueue<FCIntPtr>());
+        }
+        if(0 == strcmp(alg_name, "ctqueue")) {
+                return (new ComTreeQueue<FCIntPtr>());
+        }
+        if(0 == strcmp(alg_name, "smartctqueue")) {
+	        if ( 0 != _gConfiguration._internal_reward_mode ) 
+	                return (new ComTreeQueue<FCIntPtr,true,true>(mon, learner));
+		else
+		        return (new ComTreeQueue<FCIntPtr,true,false>(mon, learner));
+        }
         if(0 == strcmp(alg_name, "oyqueue")) {
                 return (new OyamaQueue<FCIntPtr>());
         }
@@ -792,9 +996,9 @@ FCBase<FCIntPtr>* CreateDataStructure(char* final alg_name, LearningEngine* lear
         }
         if(0 == strcmp(alg_name, "smartskiplist")) {
 	        if ( 0 != _gConfiguration._internal_reward_mode ) 
-	                return (new SmartSkipList<FCIntPtr,true,true>(_mon, learner));
+	                return (new SmartSkipList<FCIntPtr,true,true>(mon, learner));
 		else
-		        return (new SmartSkipList<FCIntPtr,true,false>(_mon, learner));
+		        return (new SmartSkipList<FCIntPtr,true,false>(mon, learner));
         }
         if(0 == strcmp(alg_name, "lfskiplist")) {
                 return (new LFSkipList<FCIntPtr>());
@@ -809,27 +1013,66 @@ FCBase<FCIntPtr>* CreateDataStructure(char* final alg_name, LearningEngine* lear
         }
         if(0 == strcmp(alg_name, "smartpairheap")) {
 	        if ( 0 != _gConfiguration._internal_reward_mode ) 
-	                return (new SmartPairHeap<FCIntPtr,true,true>(_mon, learner));
+	                return (new SmartPairHeap<FCIntPtr,true,true>(mon, learner));
+		else
+		        return (new SmartPairHeap<FCIntPtr,true,false>(mon, learner));
+        }
+        if(0 == strcmp(alg_name, "fcdaryheap")) {
+	        return (new SmartPairHeap<FCIntPtr,false,false,DaryHeap<FCIntPtr,4> >(null, null));
+        }
+        if(0 == strcmp(alg_name, "smartdaryheap")) {
+	        if ( 0 != _gConfiguration._internal_reward_mode ) 
+	                return (new SmartPairHeap<FCIntPtr,true,true,DaryHeap<FCIntPtr,4> >(mon, learner));
 		else
-		        return (new SmartPairHeap<FCIntPtr,true,false>(_mon, learner));
+		        return (new SmartPairHeap<FCIntPtr,true,false,DaryHeap<FCIntPtr,4> >(mon, learner));
+        }
+        if(0 == strcmp(alg_name, "fcdary8heap")) {
+	        return (new SmartPairHeap<FCIntPtr,false,false,DaryHeap<FCIntPtr,8> >(null, null));
+        }
+        if(0 == strcmp(alg_name, "smartdary8heap")) {
+	        if ( 0 != _gConfiguration._internal_reward_mode ) 
+	                return (new SmartPairHeap<FCIntPtr,true,true,DaryHeap<FCIntPtr,8> >(mon, learner));
+		else
+		        return (new SmartPairHeap<FCIntPtr,true,false,DaryHeap<FCIntPtr,8> >(mon, learner));
         }
         if(0 == strcmp(alg_name, "mutexpairheap")) {
 	        return (new MutexPairHeap<FCIntPtr>());
         }
+        if(0 == strcmp(alg_name, "multiheap")) {
+	        return (new SmartMultiHeap<FCIntPtr,false,false>(null, null));
+        }
+        if(0 == strcmp(alg_name, "smartmultiheap")) {
+	        if ( 0 != _gConfiguration._internal_reward_mode ) 
+	                return (new SmartMultiHeap<FCIntPtr,true,true>(mon, learner));
+		else
+		        return (new SmartMultiHeap<FCIntPtr,true,false>(mon, learner));
+        }
 
         //stack ....................................................................
         if(0 == strcmp(alg_name, "fcstack")) {
                 return (new FCStack<FCIntPtr>());
         }
-        //if(0 == strcmp(alg_name, "smartstack")) {
-        //      return (new SmartStack<FCIntPtr>(_mon));
-        //}
+        if(0 == strcmp(alg_name, "fcelimstack")) {
+	        return (new SmartStack<FCIntPtr,false,false>(null, null));
+        }
+        if(0 == strcmp(alg_name, "smartstack")) {
+	        if ( 0 != _gConfiguration._internal_reward_mode ) 
+	                return (new SmartStack<FCIntPtr,true,true>(mon, learner));
+		else
+		        return (new SmartStack<FCIntPtr,true,false>(mon, learner));
+        }
         if(0 == strcmp(alg_name, "lfstack")) {
                 return (new LFStack<FCIntPtr>());
         }
         if(0 == strcmp(alg_name, "elstack")) {
                 return (new EliminationStack<FCIntPtr>());
         }
+        if(0 == strcmp(alg_name, "smartelstack")) {
+	        if ( 0 != _gConfiguration._internal_reward_mode ) 
+	                return (new EliminationStack<FCIntPtr,true,true>(mon, learner));
+		else
+		        return (new EliminationStack<FCIntPtr,true,false>(mon, learner));
+        }
 
         if(0 == strcmp(alg_name, "heartbeat")) {
 	        return (new Hb());
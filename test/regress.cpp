@@ -38,6 +38,7 @@
 #include "SmartQueue.h"
 #include "MSQueue.h"
 #include "BasketsQueue.h"
+#include "FAAQueue.h"
 #include "ComTreeQueue.h"
 #include "OyamaQueue.h"
 #include "OyamaQueueCom.h"
@@ -45,10 +46,16 @@
 #include "LFSkipList.h"
 #include "LazySkipList.h"
 #include "SmartPairingHeap.h"
+#include "SmartMultiHeap.h"
 #include "FCStack.h"
+#include "SmartStack.h"
 #include "LFStack.h"
 #include "EliminationStack.h"
 #include "LazyCounter.h"
+#include "LatencyMonitor.h"
+#include "MuxMonitor.h"
+#include "SmartLock.h"
+#include "SmartRWLock.h"
 
 
 using namespace CCP;
@@ -74,6 +81,29 @@ const int  MAX_THREADS        = 200;
 const int  els                = (_gNumThreads-1) * 100;
 const int  MAX_ELS            = MAX_THREADS * 100;
 
+//lock test. lock_count is only touched under smartlock; writers of rwlock
+//keep rw_a and rw_b equal, so a reader that sees them differ saw a torn write
+SmartLock*            smartlock;
+SmartRWLock<int>*     rwlock;
+Monitor*              lockmon;
+const int             LOCK_ITERS     = 2000;
+volatile _u64         lock_barrier   = 0;
+volatile _u64         lock_count     = 0;
+volatile _u64         rw_a           = 0;
+volatile _u64         rw_b           = 0;
+volatile _u64         rw_torn        = 0;
+volatile _u64         pin_misses     = 0;
+//past 63 threads PRLOCK waits in groups of 64 priorities
+const int             WIDE_THREADS   = 80;
+const int             WIDE_ITERS     = 200;
+
+//shard race test. every thread adds then removes on one shard, so a remove
+//always has at least its own element to find
+SmartMultiHeap<lli,false,false>*  shardheap;
+const int             SHARD_ITERS    = 2000;
+volatile _u64         shard_barrier  = 0;
+volatile _u64         shard_misses   = 0;
+
 char            pad1[CACHE_LINE_SIZE];
 volatile char   results1[CACHE_LINE_SIZE*MAX_ELS] = {false};
 volatile char   results2[CACHE_LINE_SIZE*MAX_ELS] = {false};
@@ -250,11 +280,649 @@ bool parallel_test(FCBase<FCIntPtr>* queue, FCBase<FCIntPtr>* queue2, LazyCounte
 	return rv;
 }
 
+void * lock_func(void* args)
+{
+        ptr_t tid = (ptr_t) args;
+
+        //one thread stays ahead of the learned schedule (higher priority wins)
+        const int top = _gNumThreads - 1;
+        if ( 1 == tid )
+                smartlock->pinpriority(tid, top);
+
+	FAADD(&lock_barrier, 1);
+	while( lock_barrier != _gNumThreads );
+
+	for(int i = 0; i < LOCK_ITERS; i++)
+	{
+	        //take the SmartLock every way it can be taken
+	        switch( i % 3 ) {
+		case 0: {
+		        SmartLock::Guard g(*smartlock, tid);
+			lock_count = lock_count + 1;
+			break;
+		}
+		case 1:
+		        smartlock->lock(tid);
+			lock_count = lock_count + 1;
+			smartlock->unlock(tid);
+			break;
+		default:
+		        while( !smartlock->try_lock(tid) );
+			lock_count = lock_count + 1;
+			smartlock->unlock(tid);
+		}
+		lockmon->addreward(tid, 1);
+
+		//the pin holds whatever the learner publishes meanwhile
+		if ( (1 == tid) && (top != smartlock->getlearner()->getpermval(0, tid)) )
+		        pin_misses = pin_misses + 1;
+
+	        if ( 0 == (i & 7) ) {
+		        rwlock->write_lock(tid);
+			rw_a = rw_a + 1;
+			Memory::read_write_barrier();
+			rw_b = rw_b + 1;
+			rwlock->write_unlock(tid);
+		} else {
+		        rwlock->read_lock(tid);
+			if ( rw_a != rw_b )
+			        FAADD(&rw_torn, 1);
+			rwlock->read_unlock(tid);
+		}
+	}
+
+        if ( 1 == tid )
+                smartlock->clearpriorityhint(tid);
+
+	return NULL;
+}
+
+void * wide_lock_func(void* args)
+{
+        ptr_t tid = (ptr_t) args;
+
+	FAADD(&lock_barrier, 1);
+	while( lock_barrier != WIDE_THREADS );
+
+        //failed tries join and leave their priority group, racing the others
+	for(int i = 0; i < WIDE_ITERS; i++)
+	{
+	        while( !smartlock->try_lock(tid) )
+		        Thread::yield();
+		lock_count = lock_count + 1;
+		smartlock->unlock(tid);
+	}
+
+	return NULL;
+}
+
+bool wide_lock_test(Monitor* mon)
+{
+	bool rv = true;
+
+	try {
+
+	        smartlock = new SmartLock(WIDE_THREADS, mon);
+
+		pthread_attr_t lockthreadattr;
+		static pthread_t lockthread[WIDE_THREADS];
+
+		pthread_attr_init(&lockthreadattr);
+		pthread_attr_setdetachstate(&lockthreadattr, PTHREAD_CREATE_JOINABLE);
+
+		for(int i = 1; i < WIDE_THREADS; i++)
+		        pthread_create(&lockthread[i], &lockthreadattr, wide_lock_func, (void*) i);
+
+		wide_lock_func((void*) 0);
+
+		for(int i = 1; i < WIDE_THREADS; i++)
+		        pthread_join(lockthread[i], NULL);
+
+		if ( lock_count != (_u64) (WIDE_THREADS * WIDE_ITERS) )
+		        rv = false;
+
+		//nobody waits now, so no group may still be flagged: every
+		//thread, whatever its priority, gets the lock on its first try
+		for(int i = 0; i < WIDE_THREADS; i++) {
+		        if ( !smartlock->try_lock(i) ) {
+			        rv = false;
+				break;
+			}
+			smartlock->unlock(i);
+		}
+
+		delete smartlock;
+		lock_barrier = 0;
+		lock_count = 0;
+
+	}
+
+	catch (...) {
+	        rv = false;
+	}
+
+	if ( rv )
+	        cerr << "Passed parallel test of SmartLock with " << WIDE_THREADS << " threads" << endl;
+	else
+	        cerr << "Failed parallel test of SmartLock with " << WIDE_THREADS << " threads" << endl;
+
+	return rv;
+}
+
+
+bool lock_test(Monitor* mon)
+{
+	bool rv = true;
+
+	try {
+
+	        lockmon = mon;
+	        smartlock = new SmartLock(_gNumThreads, mon);
+		LearningEngine* learner = new LearningEngine(_gNumThreads, mon, 1.0, LearningEngine::scancount_tuning, 0, 1);
+		rwlock = new SmartRWLock<int>(_gNumThreads, learner);
+
+		pthread_attr_t lockthreadattr;
+		static pthread_t lockthread[MAX_THREADS];
+
+		pthread_attr_init(&lockthreadattr);
+		pthread_attr_setdetachstate(&lockthreadattr, PTHREAD_CREATE_JOINABLE);
+
+		for(int i = 1; i < _gNumThreads; i++)
+		        pthread_create(&lockthread[i], &lockthreadattr, lock_func, (void*) i);
+
+		lock_func((void*) 0);
+
+		for(int i = 1; i < _gNumThreads; i++)
+		        pthread_join(lockthread[i], NULL);
+
+		// test correctness
+		if ( lock_count != (_u64) (_gNumThreads * LOCK_ITERS) )
+		        rv = false;
+		if ( (rw_a != rw_b) || (rw_a != (_u64) (_gNumThreads * ((LOCK_ITERS + 7) / 8))) )
+		        rv = false;
+		if ( 0 != rw_torn )
+		        rv = false;
+		if ( 0 != pin_misses )
+		        rv = false;
+
+		// reset
+		delete rwlock;
+		delete learner;
+		delete smartlock;
+		lock_barrier = 0;
+		lock_count = 0;
+		rw_a = 0;
+		rw_b = 0;
+		rw_torn = 0;
+		pin_misses = 0;
+
+	}
+
+	catch (...) {
+	        rv = false;
+	}
+
+	if ( rv )
+	        cerr << "Passed parallel test of SmartLock and SmartRWLock" << endl;
+	else
+	        cerr << "Failed parallel test of SmartLock and SmartRWLock" << endl;
+
+	return rv;
+}
+
+bool relax_test(Monitor* mon)
+{
+        //the test sets the relaxation knob itself
+        LearningEngine* learner = new LearningEngine(_gNumThreads, mon, 1.0,
+                                                     (LearningEngine::learning_mode_t) (LearningEngine::scancount_tuning | LearningEngine::manual_stepping),
+                                                     0, 1);
+        SmartMultiHeap<lli,true,false>* heap = new SmartMultiHeap<lli,true,false>(mon, learner);
+        const int num_els = 40;
+
+        //spread the keys over every shard, then drop to a single active shard
+        learner->setdiscval(0, 12);
+        for(int i = 1; i <= num_els; i++)
+                heap->add(0, new FCIntPtrNode(i));
+        learner->setdiscval(0, 0);
+
+        //keep the active shard busy with larger keys. the smallest key must
+        //still come out within a pass over the (2 per thread) shards
+        bool rv = false;
+        for(int i = 0; (i < 2*_gNumThreads) && !rv; i++) {
+                heap->add(0, new FCIntPtrNode(num_els + 1 + i));
+                FCIntPtrNode* res = (FCIntPtrNode*) heap->remove(0, NULL);
+                rv = (NULL != res) && (1 == res->getvalue());
+                delete res;
+        }
+
+        //everything else still comes out, and then the heap reads empty
+        int left = 0;
+        FCIntPtrNode* res;
+        while( NULL != (res = (FCIntPtrNode*) heap->remove(0, NULL)) ) {
+                ++left;
+                delete res;
+        }
+        rv = rv && (left > 0) && (NULL == heap->remove(0, NULL));
+
+        delete heap;
+        delete learner;
+
+	if ( rv )
+	        cerr << "Passed relaxation test of SmartMultiHeap" << endl;
+	else
+	        cerr << "Failed relaxation test of SmartMultiHeap" << endl;
+
+	return rv;
+}
+
+void * shard_func(void* args)
+{
+        ptr_t tid = (ptr_t) args;
+
+	FAADD(&shard_barrier, 1);
+	while( shard_barrier != _gNumThreads );
+
+        //most adds are combined by another thread's pass
+	for(int i = 0; i < SHARD_ITERS; i++)
+	{
+	        shardheap->add(tid, new FCIntPtrNode(tid * SHARD_ITERS + i + 1));
+		FCIntPtrNode* res = (FCIntPtrNode*) shardheap->remove(tid, NULL);
+		if ( NULL == res )
+		        FAADD(&shard_misses, 1);
+		delete res;
+	}
+
+	return NULL;
+}
+
+bool shard_race_test()
+{
+	bool rv = true;
+
+	try {
+
+	        shardheap = new SmartMultiHeap<lli,false,false>(null, null, 1);
+
+		pthread_attr_t shardthreadattr;
+		static pthread_t shardthread[MAX_THREADS];
+
+		pthread_attr_init(&shardthreadattr);
+		pthread_attr_setdetachstate(&shardthreadattr, PTHREAD_CREATE_JOINABLE);
+
+		for(int i = 1; i < _gNumThreads; i++)
+		        pthread_create(&shardthread[i], &shardthreadattr, shard_func, (void*) i);
+
+		shard_func((void*) 0);
+
+		for(int i = 1; i < _gNumThreads; i++)
+		        pthread_join(shardthread[i], NULL);
+
+		if ( 0 != shard_misses )
+		        rv = false;
+		if ( NULL != shardheap->remove(0, NULL) )
+		        rv = false;
+
+		delete shardheap;
+		shard_barrier = 0;
+		shard_misses = 0;
+
+	}
+
+	catch (...) {
+	        rv = false;
+	}
+
+	if ( rv )
+	        cerr << "Passed shard race test of SmartMultiHeap" << endl;
+	else
+	        cerr << "Failed shard race test of SmartMultiHeap" << endl;
+
+	return rv;
+}
+
+bool latency_test()
+{
+        //half the ops take 8 ticks (bucket 3), half 1024 (bucket 10), on two channels
+        MuxMonitor* mux = new MuxMonitor(_gNumThreads, 2);
+        LatencyMonitor* lm = new LatencyMonitor(_gNumThreads);
+        for(int i = 0; i < 50; i++) {
+                mux->channel(0)->addlatency(0, 8);
+                mux->channel(1)->addlatency(_gNumThreads-1, 1024);
+                lm->addlatency(0, 8);
+                lm->addlatency(_gNumThreads-1, 1024);
+        }
+
+        _u64 hist[Monitor::LATENCY_BUCKETS];
+        _u64 hist0[Monitor::LATENCY_BUCKETS];
+        _u64 hist1[Monitor::LATENCY_BUCKETS];
+        bool rv = mux->getlatencyhist(hist) && mux->channel(0)->getlatencyhist(hist0) && mux->channel(1)->getlatencyhist(hist1);
+        rv = rv && (50 == hist[3]) && (50 == hist[10]) && (50 == hist0[3]) && (0 == hist0[10]) && (50 == hist1[10]);
+
+        //the median is the top of bucket 3, interpolated geometrically inside it
+        rv = rv && (16. == Monitor::histpercentile(hist, .5));
+        rv = rv && (fabs(Monitor::histpercentile(hist, .25) - 8*sqrt(2.)) < 1e-9);
+        rv = rv && (fabs(Monitor::histpercentile(hist, .99) - 1024*pow(2., .98)) < 1e-9);
+        rv = rv && (Monitor::histpercentile(hist0, .99) <= 16.) && (Monitor::histpercentile(hist1, .01) >= 1024.);
+        rv = rv && (fabs(lm->getpercentile(.99) - 1024*pow(2., .98)) < 1e-9);
+
+        //an empty histogram, and a monitor that doesn't measure latency
+        for(int b = 0; b < Monitor::LATENCY_BUCKETS; b++)
+                hist[b] = 0;
+        Hb* hb = new Hb(false);
+        rv = rv && (0. == Monitor::histpercentile(hist, .99)) && !hb->getlatencyhist(hist);
+
+        delete hb;
+        delete lm;
+        delete mux;
+
+	if ( rv )
+	        cerr << "Passed latency histogram test" << endl;
+	else
+	        cerr << "Failed latency histogram test" << endl;
+
+	return rv;
+}
+
+//the text of everything t has learned
+std::string saved(Tuner* t)
+{
+        std::string s;
+        FILE* f = tmpfile();
+        if ( null == f )
+                return s;
+        t->save(f);
+        rewind(f);
+        int c;
+        while ( EOF != (c = fgetc(f)) )
+                s += (char) c;
+        fclose(f);
+        return s;
+}
+
+//t2 loaded from t's save holds the same statistics
+bool reloads(Tuner* t, Tuner* t2)
+{
+        std::string s = saved(t);
+        FILE* f = tmpfile();
+        if ( (null == f) || s.empty() )
+                return false;
+        fputs(s.c_str(), f);
+        rewind(f);
+        bool rv = t2->load(f);
+        fclose(f);
+        return rv && (saved(t2) == s);
+}
+
+bool bandit_test()
+{
+        //value 2 of four pays 10, the rest 1. putting item 1 first of three
+        //pays 5 and item 0 last 1 more. the arms and the order learn in
+        //separate tuners so neither's draws blur the other's rewards; the
+        //draws are seeded, so this is deterministic
+        int val = 0, val2 = 0;
+        int perm[3] = {0, 1, 2};
+        int perm2[3] = {0, 1, 2};
+        rl_act_entry_t acts[4] = { {RLA_DISCRETE, 1, 4, &val}, {RLA_PERM, 3, 0, perm},
+                                   {RLA_DISCRETE, 1, 4, &val2}, {RLA_PERM, 3, 0, perm2} };
+        rl_act_desc_t rad[4] = { {1, &acts[0]}, {1, &acts[1]}, {1, &acts[2]}, {1, &acts[3]} };
+        double sf[1] = {1.};
+        BanditTuner* arms = new BanditTuner(&rad[0]);
+        BanditTuner* order = new BanditTuner(&rad[1]);
+        for(int i = 0; i < 500; i++) {
+                arms->sample();
+                arms->update((2 == val) ? 10 : 1, sf);
+                order->sample();
+                order->update(((1 == perm[0]) ? 5 : 0) + ((0 == perm[2]) ? 1 : 0), sf);
+        }
+        arms->greedy();
+        order->greedy();
+        bool rv = (2 == val) && (1 == perm[0]) && (2 == perm[1]) && (0 == perm[2]);
+
+        //reloaded tuners make the same greedy choices
+        BanditTuner* arms2 = new BanditTuner(&rad[2]);
+        BanditTuner* order2 = new BanditTuner(&rad[3]);
+        rv = rv && reloads(arms, arms2) && reloads(order, order2);
+        arms2->greedy();
+        order2->greedy();
+        rv = rv && (val2 == val) && (perm2[0] == perm[0]) && (perm2[1] == perm[1]) && (perm2[2] == perm[2]);
+
+        delete order2;
+        delete arms2;
+        delete order;
+        delete arms;
+
+	if ( rv )
+	        cerr << "Passed bandit tuner test" << endl;
+	else
+	        cerr << "Failed bandit tuner test" << endl;
+
+	return rv;
+}
+
+//counts how often a learner's helper looks at its reward
+class VisitMonitor : public Monitor {
+public:
+        volatile _u64 reads;
+
+        VisitMonitor(): reads(0) {}
+
+        _u64 getreward() { reads = reads + 1; return 0; }
+        _u64 getrewardnotsafe() { reads = reads + 1; return 0; }
+        _u64 getreward(_u64& changes) { reads = reads + 1; return 0; }
+        _u64 getrewardnotsafe(_u64& changes) { reads = reads + 1; return 0; }
+        void addreward(int tid, _u64 amt) {}
+        void addrewardnotsafe(int tid, _u64 amt) {}
+        _u64 waitchangenotsafe(_u64& changes) { return 0; }
+};
+
+bool visited(VisitMonitor* vm)
+{
+        for(int i = 0; (i < 500) && (0 == vm->reads); i++)
+                Thread::sleep(10);
+        return 0 != vm->reads;
+}
+
+//one helper's learners live in segments of 64 slots. fill three, free
+//every other slot and take them again
+bool lelist_test()
+{
+        const int        NUM = 150;
+        LearningEngine*  le[NUM];
+        VisitMonitor*    vm[NUM];
+
+        for(int i = 0; i < NUM; i++) {
+                vm[i] = new VisitMonitor();
+                le[i] = new LearningEngine(_gNumThreads, vm[i], 1.0, LearningEngine::scancount_tuning, 0, 1, 0);
+        }
+        bool rv = visited(vm[NUM-1]);
+
+        for(int i = 0; i < NUM; i += 2) {
+                delete le[i];
+                delete vm[i];
+        }
+        for(int i = 0; i < NUM; i += 2) {
+                vm[i] = new VisitMonitor();
+                le[i] = new LearningEngine(_gNumThreads, vm[i], 1.0, LearningEngine::scancount_tuning, 0, 1, 0);
+        }
+        rv = rv && visited(vm[0]) && visited(vm[70]) && visited(vm[NUM-2]);
+
+        for(int i = 0; i < NUM; i++) {
+                delete le[i];
+                delete vm[i];
+        }
+
+	if ( rv )
+	        cerr << "Passed learner list test" << endl;
+	else
+	        cerr << "Failed learner list test" << endl;
+
+	return rv;
+}
+
+//the run uses two helper threads (see main); learners spread over both
+bool helpers_test(Monitor* mon, LearningEngine** learner, int num_learners, bool set)
+{
+        bool rv = set && (2 == LearningEngine::gethelpers());
+
+        //too late to change now that learners exist
+        rv = rv && !LearningEngine::sethelpers(3) && (2 == LearningEngine::gethelpers());
+
+        int owned[2] = {0, 0};
+        for(int i = 0; i < num_learners; i++) {
+                int h = learner[i]->gethelper();
+                if ( (h < 0) || (h > 1) )
+                        rv = false;
+                else
+                        owned[h]++;
+        }
+        rv = rv && (owned[0] > 0) && (owned[1] > 0);
+
+        //one asked for by the constructor
+        LearningEngine* le = new LearningEngine(_gNumThreads, mon, 1.0, LearningEngine::scancount_tuning, 0, 1, 1);
+        rv = rv && (1 == le->gethelper());
+        delete le;
+
+	if ( rv )
+	        cerr << "Passed learning helpers test" << endl;
+	else
+	        cerr << "Failed learning helpers test" << endl;
+
+	return rv;
+}
+
+bool freeze_test(Monitor* mon)
+{
+        //stepped by hand on rewards the test makes up
+        LearningEngine* learner = new LearningEngine(_gNumThreads, mon, 1.0,
+                                                     (LearningEngine::learning_mode_t) (LearningEngine::scancount_tuning | LearningEngine::bandit_tuning |
+                                                                                        LearningEngine::manual_stepping | LearningEngine::policy_freezing),
+                                                     0, 1);
+
+        //a steady reward: once every value is tried the bandit keeps to its
+        //greedy pick, and after enough settled steps the learner freezes
+        bool frozen = false;
+        for(int i = 0; (i < 4096) && !frozen; i++) {
+                learner->samplediscval(0);
+                learner->step(1000.);
+                frozen = learner->isfrozen();
+        }
+
+        //frozen, sampling leaves the published value alone
+        int greedy = learner->getdiscval(0, 0);
+        bool rv = frozen && (greedy == learner->samplediscval(0));
+
+        //a spike that doesn't last keeps it frozen
+        learner->step(3000.);
+        learner->step(1000.);
+        rv = rv && learner->isfrozen();
+
+        //a lasting jump thaws it within a few steps
+        for(int i = 0; (i < 16) && learner->isfrozen(); i++)
+                learner->step(3000.);
+        rv = rv && !learner->isfrozen();
+
+        delete learner;
+
+	if ( rv )
+	        cerr << "Passed policy freezing test" << endl;
+	else
+	        cerr << "Failed policy freezing test" << endl;
+
+	return rv;
+}
+
+//replaces the first from in file path with to
+bool rewrite_file(const char* path, const char* from, const char* to)
+{
+        FILE* f = fopen(path, "r");
+        if ( NULL == f )
+                return false;
+        std::string s;
+        char buf[4096];
+        size_t n;
+        while( 0 != (n = fread(buf, 1, sizeof(buf), f)) )
+                s.append(buf, n);
+        fclose(f);
+
+        size_t at = s.find(from);
+        if ( std::string::npos == at )
+                return false;
+        s.replace(at, strlen(from), to);
+        f = fopen(path, "w");
+        if ( NULL == f )
+                return false;
+        fwrite(s.data(), 1, s.size(), f);
+        return 0 == fclose(f);
+}
+
+LearningEngine* policy_learner(Monitor* mon, int width_hi)
+{
+        LearningEngine* le = new LearningEngine(_gNumThreads, mon, 1.0,
+                                                (LearningEngine::learning_mode_t) (LearningEngine::lock_scheduling | LearningEngine::scancount_tuning | LearningEngine::manual_stepping),
+                                                1, 2);
+        le->register_sc_tune_id();
+        le->register_knob("width", 0, width_hi);
+        return le;
+}
+
+bool policy_test(Monitor* mon)
+{
+        const char* name = "regress";
+        char path[1024];
+        snprintf(path, sizeof(path), "./%s.%d.policy", name, _gNumThreads);
+        unlink(path);
+
+        //write: nothing to warm start from yet, then save a known setting
+        LearningEngine* a = policy_learner(mon, 4);
+        a->setdiscval(0, 7);
+        a->setdiscval(1, 3);
+        bool rv = !a->warmstart(name) && a->savepolicy();
+
+        //read it back into a learner of the same shape
+        LearningEngine* b = policy_learner(mon, 4);
+        rv = rv && b->warmstart(name) && (7 == b->getdiscval(0, 0)) && (3 == b->getknob(1, 0));
+
+        //warm started before its knobs register, it takes the saved ranges
+        //and the knob keeps the loaded value when it registers
+        LearningEngine* c = new LearningEngine(_gNumThreads, mon, 1.0, a->getmode(), 1, 2);
+        rv = rv && c->warmstart(name);
+        c->register_sc_tune_id();
+        c->register_knob("width", 0, 4);
+        rv = rv && (7 == c->getdiscval(0, 0)) && (3 == c->getknob(1, 0));
+
+        //a knob registered with another range doesn't match
+        LearningEngine* d = policy_learner(mon, 5);
+        rv = rv && !d->warmstart(name);
+
+        //a repeated thread in the permutation, or a value out of its knob's range
+        char perm[64];
+        snprintf(perm, sizeof(perm), "perm %d", _gNumThreads-1);
+        rv = rv && a->savepolicy() && rewrite_file(path, "perm 0", perm) && !b->warmstart(name);
+        rv = rv && a->savepolicy() && rewrite_file(path, "disc 7 3", "disc 7 5") && !b->warmstart(name);
+        rv = rv && a->savepolicy() && rewrite_file(path, "disc 7 3", "disc 13 3") && !b->warmstart(name);
+        rv = rv && a->savepolicy() && b->warmstart(name);
+
+        //each saves again when destroyed
+        delete d;
+        delete c;
+        delete b;
+        delete a;
+        unlink(path);
+
+	if ( rv )
+	        cerr << "Passed policy round trip test" << endl;
+	else
+	        cerr << "Failed policy round trip test" << endl;
+
+	return rv;
+}
+
 
 enum TESTTYPE {
         FIFO,
 	PRI,
-	LIFO
+	LIFO,
+	RELAXED
 };
 
 bool serial_test(FCBase<FCIntPtr>* queue, TESTTYPE type)
@@ -300,6 +968,24 @@ bool serial_test(FCBase<FCIntPtr>* queue, TESTTYPE type)
 			}
 			errs += (queue->remove(0, NULL) == FCBase<FCIntPtr>::_NULL_VALUE) ? 0 : 1;  
 			break;
+		case RELAXED:
+		        //any order is allowed but every value must come out exactly once
+		        {
+			        bool seen[NUMVALS] = {false};
+			        for(int i = 0; i < NUMVALS; i++) {
+				        res = (FCIntPtrNode*) queue->remove(0, NULL);
+					int k = 0;
+					while( (k < NUMVALS) && ((res->getvalue() != vals[k]) || seen[k]) )
+					        k++;
+					if ( k < NUMVALS )
+					        seen[k] = true;
+					else
+					        errs++;
+					delete res;
+				}
+			}
+			errs += (queue->remove(0, NULL) == FCBase<FCIntPtr>::_NULL_VALUE) ? 0 : 1;  
+			break;
 		default:
 		        break;
 		}
@@ -341,44 +1027,68 @@ bool destruct_test(FCBase<lli>** ds1, FCBase<lli>** ds2, int num_ds, LazyCounter
 
 int main(int argc, char* argv[])
 {
-        const int             NUMDS = 16;
+        const int             NUMDS = 27;
         LearningEngine**      learner = new LearningEngine*[NUMDS];
         Hb*                   hbmon = new Hb();
 
+        //before any learner exists: tune on two helper threads
+        bool helpers_set = LearningEngine::sethelpers(2);
 
         int mode = LearningEngine::scancount_tuning;
         double rl_to_sleepidle_ratio = 1.0;
         int num_lock_sched = 0;
         int num_sc_tune = 1;
 	for (int i = 0; i < NUMDS; i++) {
+	        //12-17 drive structures with two knobs (elimination width and
+	        //wait, backoff base and cap)
+	        int num_knobs = ((i >= 12) && (i <= 17)) ? 2 : 1;
+	        int learner_mode = mode;
+	        //the SmartQueue learners also pick the SmartLockLite algorithm
+	        if ( (0 == i) || (3 == i) ) {
+	                learner_mode |= LearningEngine::lock_alg_tuning;
+	                ++num_knobs;
+	        }
 	        learner[i] =  new LearningEngine(_gNumThreads, 
 						 hbmon, 
 						 rl_to_sleepidle_ratio,
-						 (LearningEngine::learning_mode_t) mode,
+						 (LearningEngine::learning_mode_t) learner_mode,
 						 num_lock_sched,
-						 num_sc_tune
+						 num_knobs*num_sc_tune
 						 );
 	}
 
 	FCBase<lli>* ds1[NUMDS] = { new SmartQueue<lli,false,false>(null,null), new SmartQueue<lli,true,true>(hbmon, learner[0]), new MSQueue<lli>(), new BasketsQueue<lli>(),
-                                    null /*new ComTreeQueue<lli>()*/, new OyamaQueue<lli>(), null /*new OyamaQueueCom<lli>()*/,
+                                    new ComTreeQueue<lli>(), new OyamaQueue<lli>(), null /*new OyamaQueueCom<lli>()*/, new FAAQueue<lli>(),
+                                    new MSQueue<lli,true,true>(hbmon, learner[14]), new BasketsQueue<lli,true,true>(0, hbmon, learner[15]),
+                                    new ComTreeQueue<lli,true,true>(hbmon, learner[18]),
 				    new SmartSkipList<lli,false,false>(null,null), new SmartSkipList<lli,true,true>(hbmon, learner[1]), new LFSkipList<lli>(),
 				    new LazySkipList<lli>(), new SmartPairHeap<lli,false,false>(null,null), new SmartPairHeap<lli,true,true>(hbmon, learner[2]),
-                                    new FCStack<lli>(), new LFStack<lli>(), new EliminationStack<lli>() };
+                                    new SmartPairHeap<lli,false,false,DaryHeap<lli,4> >(null,null), new SmartPairHeap<lli,true,true,DaryHeap<lli,8> >(hbmon, learner[8]),
+                                    new FCStack<lli>(), new LFStack<lli>(), new EliminationStack<lli>(),
+                                    new EliminationStack<lli,true,true>(hbmon, learner[12]),
+                                    new SmartStack<lli,false,false>(null,null), new SmartStack<lli,true,true>(hbmon, learner[10]),
+                                    new SmartMultiHeap<lli,false,false>(null,null), new SmartMultiHeap<lli,true,true>(hbmon, learner[6]) };
 
 #ifdef QUEUE2
         FCBase<lli>* ds2[NUMDS] = { new SmartQueue<lli,false,false>(null,null), new SmartQueue<lli,true,true>(hbmon, learner[3]), new MSQueue<lli>(), new BasketsQueue<lli>(),
-                                    null /*new ComTreeQueue<lli>()*/, new OyamaQueue<lli>(), null /*new OyamaQueueCom<lli>()*/,
+                                    new ComTreeQueue<lli>(), new OyamaQueue<lli>(), null /*new OyamaQueueCom<lli>()*/, new FAAQueue<lli>(),
+                                    new MSQueue<lli,true,true>(hbmon, learner[16]), new BasketsQueue<lli,true,true>(0, hbmon, learner[17]),
+                                    new ComTreeQueue<lli,true,true>(hbmon, learner[19]),
                                     new SmartSkipList<lli,false,false>(null,null), new SmartSkipList<lli,true,true>(hbmon, learner[4]), new LFSkipList<lli>(),
                                     new LazySkipList<lli>(), new SmartPairHeap<lli,false,false>(null,null), new SmartPairHeap<lli,true,true>(hbmon, learner[5]),
-                                    new FCStack<lli>(), new LFStack<lli>(), new EliminationStack<lli>() };
+                                    new SmartPairHeap<lli,false,false,DaryHeap<lli,4> >(null,null), new SmartPairHeap<lli,true,true,DaryHeap<lli,8> >(hbmon, learner[9]),
+                                    new FCStack<lli>(), new LFStack<lli>(), new EliminationStack<lli>(),
+                                    new EliminationStack<lli,true,true>(hbmon, learner[13]),
+                                    new SmartStack<lli,false,false>(null,null), new SmartStack<lli,true,true>(hbmon, learner[11]),
+                                    new SmartMultiHeap<lli,false,false>(null,null), new SmartMultiHeap<lli,true,true>(hbmon, learner[7]) };
 #else
         FCBase<lli>* ds2[NUMDS] = {null};
 #endif
         LazyCounter* lc = new LazyCounter(_gNumThreads,true);
 
-        int PRISTART = 7;
-        int STACKSTART = 13;
+        int PRISTART = 11;
+        int STACKSTART = 19;
+        int RELAXSTART = 25;
 
 
         Memory::read_write_barrier();
@@ -396,7 +1106,7 @@ int main(int argc, char* argv[])
                 lazycounter = lc;
 
                 for(int i = 0; i < NUMTRIALS; i++) {
-                        TESTTYPE type = (j < PRISTART) ? FIFO : ((j < STACKSTART) ? PRI : LIFO);
+                        TESTTYPE type = (j < PRISTART) ? FIFO : ((j < STACKSTART) ? PRI : ((j < RELAXSTART) ? LIFO : RELAXED));
                         rv = serial_test(queue, type);
                         megafails += rv ? 0 : 1;
                         megaskips += (null == queue) ? 1 : 0;
@@ -422,7 +1132,56 @@ int main(int argc, char* argv[])
                 megatotal &= ptotal;
         }
 
-        bool rv = destruct_test(ds1, ds2, NUMDS, lc, hbmon, learner);
+        bool ltotal = true;
+        for(int i = 0; i < NUMTRIALS; i++) {
+                bool rv = lock_test(hbmon);
+                megafails += rv ? 0 : 1;
+                ltotal &= rv;
+        }
+        if ( ltotal )
+                cerr << "Passed all parallel tests of SmartLock and SmartRWLock" << endl;
+        megatotal &= ltotal;
+
+        //single runs of the tuning tests
+        int megaextra = 0;
+        bool rv = relax_test(hbmon);
+        megafails += rv ? 0 : 1;
+        megatotal &= rv;
+        ++megaextra;
+        rv = shard_race_test();
+        megafails += rv ? 0 : 1;
+        megatotal &= rv;
+        ++megaextra;
+        rv = latency_test();
+        megafails += rv ? 0 : 1;
+        megatotal &= rv;
+        ++megaextra;
+        rv = bandit_test();
+        megafails += rv ? 0 : 1;
+        megatotal &= rv;
+        ++megaextra;
+        rv = policy_test(hbmon);
+        megafails += rv ? 0 : 1;
+        megatotal &= rv;
+        ++megaextra;
+        rv = helpers_test(hbmon, learner, NUMDS, helpers_set);
+        megafails += rv ? 0 : 1;
+        megatotal &= rv;
+        ++megaextra;
+        rv = lelist_test();
+        megafails += rv ? 0 : 1;
+        megatotal &= rv;
+        ++megaextra;
+        rv = freeze_test(hbmon);
+        megafails += rv ? 0 : 1;
+        megatotal &= rv;
+        ++megaextra;
+        rv = wide_lock_test(hbmon);
+        megafails += rv ? 0 : 1;
+        megatotal &= rv;
+        ++megaextra;
+
+        rv = destruct_test(ds1, ds2, NUMDS, lc, hbmon, learner);
         megafails += rv ? 0 : 1;
         megatotal &= rv;
 
@@ -431,7 +1190,7 @@ int main(int argc, char* argv[])
         if ( megatotal )
                 cerr << "Passed all tests" << endl;
         else
-                cerr << "Failed " << megafails << " out of " << (NUMDS*NUMTRIALS*2) 
+                cerr << "Failed " << megafails << " out of " << (NUMDS*NUMTRIALS*2 + NUMTRIALS + megaextra) 
                      << " tests. " << megaskips << " were due to skips. Check output" << endl;
 
 }
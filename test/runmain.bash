@@ -43,6 +43,17 @@ threads="14"
 
 #which algorithms to benchmark
 #algorithms="fcqueue fcskiplist fcpairheap smartqueue smartskiplist smartpairheap msqueue basketsqueue basketsqueue oyqueue oyqueuecom lfskiplist lazyskiplist"
+#stacks
+#algorithms="fcstack lfstack elstack smartelstack fcelimstack smartstack"
+#fetch-and-add queue vs the flat combining ones
+#algorithms="fcqueue smartqueue msqueue faaqueue"
+#algorithms="msqueue smartmsqueue basketsqueue smartbasketsqueue"
+#combining tree queue, fixed binary vs learned fan-in
+#algorithms="fcqueue smartqueue ctqueue smartctqueue"
+#array-backed (4-ary / 8-ary) priority queues
+#algorithms="fcdaryheap smartdaryheap fcdary8heap smartdary8heap"
+#relaxed priority queues
+#algorithms="multiheap smartmultiheap"
 algorithms="fcqueue smartqueue"
 #algorithms="smartqueue smartskiplist smartpairheap"
 #algorithms="smartskiplist"
@@ -98,6 +109,12 @@ dynamicworkintervals="0"
 #scancount tuning on
 scancounttuning="1"
 lockscheduling="0"
+#scancount tuning on, and let SmartLockLite learn PRLOCK/TTAS/QUEUE
+#scancounttuning="2"
+#lockscheduling="0"
+#scancount tuning on, learned by the UCB bandit instead of the NAC
+#scancounttuning="3"
+#lockscheduling="0"
 
 #configure to simulate slowdown of rl thread 
 #rltime / totaltime
@@ -117,6 +134,27 @@ numds="1"
 #use this for app-specific reward
 internalreward="1"
 
+#what the learners optimize
+#throughput
+rewardmode="0"
+#p99 latency of the data structure ops
+#rewardmode="1"
+#throughput traded against p99 latency
+#rewardmode="2"
+
+#whether each run starts from the policy the previous run learned
+warmstart="0"
+#warmstart="1"
+
+#whether the learners stop exploring once the reward settles
+policyfreezing="0"
+#policyfreezing="1"
+
+#learning helper threads; each group's learner goes to the least loaded one
+#0 keeps the default of one
+helpers="0"
+#helpers="2"
+
 #how many trials of each experiment to perform
 reps="0 1 2 3 4 5 6 7 8 9"
 
@@ -149,9 +187,9 @@ for rltosleepidleratio in $rltosleepidleratios; do
 
         line=""
 	if [ "$scancount" = "0" ]; then
-                 line="$algorithm $num non 0 non 0 non 0 $count $thread $addops $removeops 0.0 $capacity 10 $dedicated 0 $delay $thread $syncinterval $scancounttuning $lockscheduling $dynamicworkamt $interval $rltosleepidleratio $internalreward"
+                 line="$algorithm $num non 0 non 0 non 0 $count $thread $addops $removeops 0.0 $capacity 10 $dedicated 0 $delay $thread $syncinterval $scancounttuning $lockscheduling $dynamicworkamt $interval $rltosleepidleratio $internalreward $rewardmode $warmstart $policyfreezing $helpers"
 	else
-                 line="$algorithm $num non 0 non 0 non 0 $count $thread $addops $removeops 0.0 $capacity 10 $dedicated 0 $delay $scancount $syncinterval $scancounttuning $lockscheduling $dynamicworkamt $interval $rltosleepidleratio $internalreward"
+                 line="$algorithm $num non 0 non 0 non 0 $count $thread $addops $removeops 0.0 $capacity 10 $dedicated 0 $delay $scancount $syncinterval $scancounttuning $lockscheduling $dynamicworkamt $interval $rltosleepidleratio $internalreward $rewardmode $warmstart $policyfreezing $helpers"
 	fi
 
         for rep in $reps; do